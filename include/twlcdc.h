@@ -26,6 +26,7 @@
 #ifndef __LIBTWLCDC_H__
 #define __LIBTWLCDC_H__
 
+#include <stdio.h>
 #include <3ds.h>
 
 #ifdef __cplusplus
@@ -46,6 +47,16 @@ typedef struct twlcdcTouchCalibration {
     s16 calY2px; //!< Pixel Y value, bottom right; typically 240 - 24
 } twlcdcTouchCalibration;
 
+/**
+ * @brief Touch calibration reference point.
+ */
+typedef struct twlcdcCalibrationPoint {
+    s16 rawx; //!< Raw X ADC value
+    s16 rawy; //!< Raw Y ADC value
+    s16 px;   //!< Pixel X value
+    s16 py;   //!< Pixel Y value
+} twlcdcCalibrationPoint;
+
 /**
  * @brief Touch position data structure.
  */
@@ -58,6 +69,420 @@ typedef struct twlcdcTouchPosition {
     u16	z2;   //!< Raw cross-panel resistance (Z2)
 } twlcdcTouchPosition;
 
+/// Number of sample sets held by the controller's data buffer.
+#define TWLCDC_TOUCH_SAMPLES_PER_READ 5
+
+#define TWLCDC_POSITION_OFF_LEFT   BIT(0) //!< Position is left of the screen
+#define TWLCDC_POSITION_OFF_RIGHT  BIT(1) //!< Position is right of the screen
+#define TWLCDC_POSITION_OFF_TOP    BIT(2) //!< Position is above the screen
+#define TWLCDC_POSITION_OFF_BOTTOM BIT(3) //!< Position is below the screen
+
+/**
+ * @brief Extended touch position data structure.
+ */
+typedef struct twlcdcTouchPositionEx {
+    twlcdcTouchPosition pos; //!< Touch position
+    u32 resistance; //!< Touch resistance, rawx * (z2 / z1 - 1) in 1/4096 units; 0 if not measurable
+    u32 pressure;   //!< Pressure estimate (roughly, contact radius), 16.16 fixed point; 0 if not measurable
+    s32 fx;         //!< Pixel X value, 16.16 fixed point, not clamped to the screen; pos.px is the integer part, clamped
+    s32 fy;         //!< Pixel Y value, 16.16 fixed point, not clamped to the screen; pos.py is the integer part, clamped
+    u32 flags;      //!< TWLCDC_POSITION_OFF_* flags, set when the unclamped position lies outside the screen
+    u32 level;      //!< Pressure normalized to this device, 0 (lightest) to 0x10000 (firmest); 0 unless pressure tracking is enabled
+} twlcdcTouchPositionEx;
+
+/**
+ * @brief Pressure scaling model.
+ *
+ * The pressure estimate is calculated as
+ * maxPressure * maxRadius / resistance.
+ */
+typedef struct twlcdcPressureModel {
+    u32 maxPressure; //!< Resistance scale; default 0x00DE0000
+    u16 maxRadius;   //!< Output scale; default 128
+} twlcdcPressureModel;
+
+/**
+ * @brief Self-tuning pressure tracker state.
+ *
+ * Tracks the 10th and 90th percentiles of touch resistance over all
+ * samples seen, in fixed memory; pressure is normalized between them.
+ * The state may be saved and restored as-is, to keep what was learned
+ * about a device between runs.
+ */
+typedef struct twlcdcPressureTracker {
+    u32 low;   //!< Resistance at the firm end of the range
+    u32 high;  //!< Resistance at the light end of the range
+    u32 count; //!< Number of samples seen
+} twlcdcPressureTracker;
+
+/**
+ * @brief Pen event type.
+ */
+typedef enum {
+    TWLCDC_EVENT_DOWN = 0, //!< Pen touched the screen
+    TWLCDC_EVENT_MOVE = 1, //!< Pen moved while touching the screen
+    TWLCDC_EVENT_UP = 2    //!< Pen lifted from the screen
+} twlcdcEventType;
+
+/**
+ * @brief Pen event.
+ */
+typedef struct twlcdcEvent {
+    twlcdcEventType type; //!< Event type
+    u64 tick; //!< System tick at which the event occurred
+    u16 px;   //!< Pixel X value; for TWLCDC_EVENT_UP, that of the last DOWN or MOVE event
+    u16 py;   //!< Pixel Y value; for TWLCDC_EVENT_UP, that of the last DOWN or MOVE event
+} twlcdcEvent;
+
+/**
+ * @brief Pen event tracker configuration.
+ */
+typedef struct twlcdcEventConfig {
+    u64 downDebounce; //!< Contact time required before a press is reported, in system ticks
+    u64 upDebounce;   //!< Release time required before a release is reported, in system ticks
+    u16 moveThreshold; //!< Distance from the last reported position required to report a move, in pixels
+} twlcdcEventConfig;
+
+#define TWLCDC_EVENT_QUEUE_SIZE 16
+
+/**
+ * @brief Pen event tracker state.
+ *
+ * Turns a stream of pen samples into debounced press, move and release
+ * events. The contents are private; use the twlcdcEvent* functions.
+ */
+typedef struct twlcdcEventTracker {
+    twlcdcEventConfig config;
+    u8 state;
+    u8 head;
+    u8 count;
+    u16 lastX, lastY;
+    u64 pendingTick;
+    twlcdcEvent queue[TWLCDC_EVENT_QUEUE_SIZE];
+} twlcdcEventTracker;
+
+/**
+ * @brief Gesture type.
+ */
+typedef enum {
+    TWLCDC_GESTURE_TAP = 0,        //!< Short press without movement
+    TWLCDC_GESTURE_DOUBLE_TAP = 1, //!< Second tap close to a previous one; follows its TWLCDC_GESTURE_TAP
+    TWLCDC_GESTURE_LONG_PRESS = 2, //!< Press held without movement; reported while still held
+    TWLCDC_GESTURE_SWIPE = 3,      //!< Press moved and released
+    TWLCDC_GESTURE_FLICK = 4       //!< Press moved and released at speed
+} twlcdcGestureType;
+
+/**
+ * @brief Gesture.
+ */
+typedef struct twlcdcGesture {
+    twlcdcGestureType type; //!< Gesture type
+    u64 tick; //!< System tick at which the gesture was recognized
+    u16 px;   //!< Pixel X value at which the press started
+    u16 py;   //!< Pixel Y value at which the press started
+    s16 dx;   //!< X movement since the press started, in pixels
+    s16 dy;   //!< Y movement since the press started, in pixels
+    s32 vx;   //!< Smoothed X velocity, in 16.16 fixed point pixels per second
+    s32 vy;   //!< Smoothed Y velocity, in 16.16 fixed point pixels per second
+} twlcdcGesture;
+
+/**
+ * @brief Gesture recognizer configuration.
+ */
+typedef struct twlcdcGestureConfig {
+    u64 upDebounce;     //!< Release time required before a release is recognized, in system ticks
+    u64 tapTicks;       //!< Maximum press duration of a tap, in system ticks
+    u64 doubleTapTicks; //!< Maximum time between a tap's release and the next press for a double tap, in system ticks
+    u64 longPressTicks; //!< Press duration of a long press, in system ticks
+    u16 tapSlop;        //!< Movement allowed during a tap or long press, in pixels
+    u16 swipeDistance;  //!< Movement required for a swipe, in pixels
+    u32 flickSpeed;     //!< Release speed required for a flick, in pixels per second
+    u32 velocityWeight; //!< Velocity smoothing weight of each new sample, in 16.16 fixed point; e.g. 0.3
+} twlcdcGestureConfig;
+
+#define TWLCDC_GESTURE_QUEUE_SIZE 8
+
+/**
+ * @brief Gesture recognizer state.
+ *
+ * Processes each pen sample in constant time, without allocation.
+ * The contents are private; use the twlcdcGesture* functions.
+ */
+typedef struct twlcdcGestureRecognizer {
+    twlcdcGestureConfig config;
+    u8 state;
+    u8 head;
+    u8 count;
+    bool moved;
+    bool longPressed;
+    bool tapPending;
+    u16 startX, startY;
+    u16 lastX, lastY;
+    u16 tapX, tapY;
+    s32 vx, vy;
+    u64 downTick, lastTick, upTick, tapTick;
+    twlcdcGesture queue[TWLCDC_GESTURE_QUEUE_SIZE];
+} twlcdcGestureRecognizer;
+
+/**
+ * @brief Contact classification.
+ */
+typedef enum {
+    TWLCDC_CONTACT_NONE = 0,    //!< Pen up
+    TWLCDC_CONTACT_SINGLE = 1,  //!< Single contact
+    TWLCDC_CONTACT_DUAL = 2,    //!< Probable dual contact; the position is their midpoint
+    TWLCDC_CONTACT_UNSTABLE = 3 //!< Too few or too inconsistent samples to classify
+} twlcdcContactType;
+
+/**
+ * @brief Contact classifier configuration.
+ */
+typedef struct twlcdcContactConfig {
+    u32 dualRatio;        //!< Touch resistance relative to both the single contact baseline and the last single contact below which a dual contact may be reported, in 16.16 fixed point; e.g. 0.6
+    u32 baselineWeight;   //!< Baseline smoothing weight of each single contact sample, in 16.16 fixed point; e.g. 0.1
+    u16 separationScale;  //!< Contact separation estimate for a resistance drop of 100%, in pixels
+    u16 maxSpread;        //!< Largest raw X/Y spread between sample sets of a stable sample
+    u16 jumpDistance;     //!< Position jump from the last single contact, in pixels, beyond which a resistance drop is reported as a dual contact; if non-zero, such positions are also suppressed while not single
+} twlcdcContactConfig;
+
+/**
+ * @brief Classified contact.
+ */
+typedef struct twlcdcContact {
+    twlcdcContactType type;   //!< Contact classification
+    twlcdcTouchPosition pos;  //!< Average position; the last single contact position if suppressed
+    u32 resistance;           //!< Average touch resistance, as in twlcdcTouchPositionEx
+    u16 separation;           //!< Estimated separation of a dual contact, in pixels
+    bool suppressed;          //!< Position was suppressed as a midpoint jump
+} twlcdcContact;
+
+/**
+ * @brief Contact classifier state.
+ *
+ * The contents are private; use the twlcdcContact* functions.
+ */
+typedef struct twlcdcContactClassifier {
+    twlcdcContactConfig config;
+    bool primed;
+    u8 settling;
+    u32 baseline;
+    u32 lastResistance;
+    twlcdcTouchPosition lastSingle;
+} twlcdcContactClassifier;
+
+/**
+ * @brief Adaptive smoothing filter configuration.
+ *
+ * The filter's cutoff frequency rises with pen speed: slow movement is
+ * smoothed heavily to remove jitter, fast movement lightly to limit lag.
+ */
+typedef struct twlcdcSmootherConfig {
+    u32 minCutoff; //!< Cutoff frequency at rest, in 24.8 fixed point Hz; e.g. 1 Hz
+    u32 beta;      //!< Cutoff frequency increase per pixel per second of speed, in 16.16 fixed point Hz
+    u32 predictUs; //!< Prediction horizon, in microseconds; 0 disables prediction
+    u32 alphaGain; //!< Predictor position gain, in 16.16 fixed point; e.g. 0.5
+    u32 betaGain;  //!< Predictor velocity gain, in 16.16 fixed point; e.g. 0.1
+} twlcdcSmootherConfig;
+
+/**
+ * @brief Adaptive smoothing filter state, for one stream of positions.
+ *
+ * The contents are private; use the twlcdcSmoother* functions.
+ */
+typedef struct twlcdcSmoother {
+    twlcdcSmootherConfig config;
+    bool primed;
+    u64 lastTick;
+    s32 x[2], ab[2];
+    s64 dx[2], v[2];
+} twlcdcSmoother;
+
+/**
+ * @brief Stroke point.
+ */
+typedef struct twlcdcStrokePoint {
+    s32 x;        //!< X coordinate, 16.16 fixed point pixels
+    s32 y;        //!< Y coordinate, 16.16 fixed point pixels
+    u32 pressure; //!< Pressure, in any unit; interpolated linearly
+} twlcdcStrokePoint;
+
+/**
+ * @brief Stroke smoothing mode.
+ */
+typedef enum {
+    TWLCDC_STROKE_LINEAR = 0,     //!< Resample along straight lines between input points
+    TWLCDC_STROKE_CATMULL_ROM = 1 //!< Resample along a centripetal Catmull-Rom spline through the input points; adds one point of latency
+} twlcdcStrokeSmoothing;
+
+/**
+ * @brief Stroke resampler state.
+ *
+ * Output points are appended to arena; arena[0] to arena[count - 1] are
+ * valid. Other contents are private; use the twlcdcStroke* functions.
+ */
+typedef struct twlcdcStroke {
+    twlcdcStrokePoint* arena; //!< Output point buffer
+    size_t capacity;          //!< Output point buffer capacity
+    size_t count;             //!< Number of output points
+    s32 spacing;
+    twlcdcStrokeSmoothing smoothing;
+    bool overflow;
+    u8 ctrlCount;
+    twlcdcStrokePoint ctrl[4];
+    twlcdcStrokePoint cursor;
+    s64 traveled;
+} twlcdcStroke;
+
+/**
+ * @brief Touch screen controller register backend.
+ *
+ * By default, registers are accessed through cdc:CHK. A custom backend
+ * can be installed to route the TSC register banks elsewhere, such as
+ * to a simulated or recorded controller. Optional members may be NULL;
+ * zero-initialize the structure before filling it in.
+ */
+typedef struct twlcdcBackend {
+    //! Read size consecutive registers, starting at reg.
+    Result (*readRegisters)(void* userdata, u8 bank, u8 reg, void* data, size_t size);
+    //! Write size consecutive registers, starting at reg.
+    Result (*writeRegisters)(void* userdata, u8 bank, u8 reg, const void* data, size_t size);
+    void* userdata; //!< Passed as the first argument to the callbacks
+    //! Optional: system tick used to timestamp samples; NULL uses svcGetSystemTick().
+    u64 (*getTick)(void* userdata);
+    //! Optional: read size consecutive CTR-mode codec registers, starting at reg.
+    //! Used with writeCtrRegisters to hand the TSC over to and back from TWL
+    //! mode on init and exit; if either is NULL, the handover is skipped.
+    Result (*readCtrRegisters)(void* userdata, u8 page, u8 reg, void* data, size_t size);
+    //! Optional: write size consecutive CTR-mode codec registers, starting at reg.
+    Result (*writeCtrRegisters)(void* userdata, u8 page, u8 reg, const void* data, size_t size);
+} twlcdcBackend;
+
+/**
+ * @brief Touch trace replay state.
+ *
+ * The contents are private; use the twlcdcReplay* functions.
+ */
+typedef struct twlcdcReplay {
+    const u8* data;
+    size_t count;
+    size_t position;
+    u64 tick;
+} twlcdcReplay;
+
+/**
+ * @brief Operations timed by the statistics collector.
+ */
+typedef enum {
+    TWLCDC_STAT_INIT = 0,     //!< twlcdcInit()
+    TWLCDC_STAT_RESUME = 1,   //!< Controller reconfiguration on return from suspend or sleep
+    TWLCDC_STAT_PEN_DOWN = 2, //!< twlcdcTouchPenDown()
+    TWLCDC_STAT_READ = 3,     //!< twlcdcTouchRead()
+    TWLCDC_STAT_POLL = 4,     //!< twlcdcTouchPoll()
+    TWLCDC_STAT_COUNT
+} twlcdcStatOp;
+
+#define TWLCDC_STATS_HISTOGRAM_SIZE 16
+//! Histogram bucket i counts latencies of [2^(i+SHIFT), 2^(i+SHIFT+1)) ticks;
+//! the first and last buckets also count everything below and above.
+#define TWLCDC_STATS_HISTOGRAM_SHIFT 8
+
+/**
+ * @brief Latency statistics for one operation, in system ticks.
+ */
+typedef struct twlcdcLatencyStats {
+    u32 count;      //!< Number of calls
+    u64 minTicks;   //!< Shortest call
+    u64 maxTicks;   //!< Longest call
+    u64 totalTicks; //!< Sum of all calls; divide by count for the average
+    u32 histogram[TWLCDC_STATS_HISTOGRAM_SIZE]; //!< Logarithmic latency histogram
+} twlcdcLatencyStats;
+
+/**
+ * @brief Library statistics.
+ */
+typedef struct twlcdcStats {
+    u32 ipcTouchCnt;    //!< Register backend round-trips to the CDC_TOUCHCNT bank
+    u32 ipcTouchData;   //!< Register backend round-trips to the CDC_TOUCHDATA bank
+    u32 ipcOther;       //!< Register backend round-trips to other banks and CTR-mode pages
+    u32 invalidSamples; //!< Readings rejected as invalid or too noisy
+    twlcdcLatencyStats latency[TWLCDC_STAT_COUNT]; //!< Latency statistics, indexed by twlcdcStatOp
+} twlcdcStats;
+
+/**
+ * @brief Pen state detection mode for twlcdcTouchPoll().
+ */
+typedef enum {
+    TWLCDC_POLL_FAST = 0,    //!< Infer pen state from the data buffer; one IPC per call
+    TWLCDC_POLL_CHECKED = 1  //!< Check the status registers first; up to two IPCs per call
+} twlcdcPollMode;
+
+/**
+ * @brief Filter used to reduce the five samples of each TSC reading.
+ */
+typedef enum {
+    TWLCDC_FILTER_MEAN = 0,          //!< Average of all samples (default)
+    TWLCDC_FILTER_MEDIAN = 1,        //!< Median of all samples
+    TWLCDC_FILTER_TRIMMED_MEAN = 2,  //!< Average of all samples but the smallest and largest
+    TWLCDC_FILTER_REJECT_SPREAD = 3  //!< Average, rejecting readings whose X or Y spread is too large
+} twlcdcFilter;
+
+/**
+ * @brief Touch screen controller conversion settings.
+ *
+ * Each field maps to a register field of the CDC_TOUCHCNT bank; values
+ * are not range-checked.
+ */
+typedef struct twlcdcTscConfig {
+    u8 clockDivider;      //!< Conversion clock divider, as a power of two (0x02, bits 3-4)
+    u8 conversionMode;    //!< Conversion and scan mode (0x03)
+    u8 prechargeTime;     //!< Panel precharge time (0x04, bits 4-6)
+    u8 senseTime;         //!< Panel sense time (0x04, bits 0-2)
+    u8 stabilizationTime; //!< Panel voltage stabilization time (0x05, bits 0-2)
+    u8 bufferTrigger;     //!< Data buffer trigger level (0x0E, bits 3-5)
+    u8 scanTimer;         //!< Scan timer enable (0x0F, bit 7) and interval (bits 4-6: 1 to 7 ms, 0 for 8 ms)
+    u8 scanTimerClock;    //!< Scan timer clock source (0x12, bits 0-2)
+} twlcdcTscConfig;
+
+/**
+ * @brief Predefined touch screen controller conversion profiles.
+ *
+ * The sample rates given are those of the scan timer, one conversion set
+ * per interval; every profile's conversions fit well within its interval.
+ */
+typedef enum {
+    //! Same settings as DSi mode, 2 ms scan interval (500 Hz); the
+    //! reference point for the other profiles.
+    TWLCDC_PROFILE_DEFAULT = 0,
+    //! Faster conversion clock, shorter settling times and the shortest
+    //! scan interval, 1 ms (1000 Hz); freshest samples, at the cost of
+    //! more noise.
+    TWLCDC_PROFILE_LOW_LATENCY = 1,
+    //! Default conversion settings with the longest scan interval, 8 ms
+    //! (125 Hz); the converter is idle most of the time.
+    TWLCDC_PROFILE_LOW_POWER = 2,
+    //! Default conversion clock and scan interval, 2 ms (500 Hz), with the
+    //! longest settling times; least noise.
+    TWLCDC_PROFILE_HIGH_ACCURACY = 3
+} twlcdcProfile;
+
+/**
+ * @brief Timestamped touch sample, as produced by the background sampler.
+ */
+typedef struct twlcdcTouchSample {
+    u64 tick;                //!< System tick at which the sample was taken
+    twlcdcTouchPosition pos; //!< Touch position; only valid if penDown is set
+    bool penDown;            //!< Pen state at the time of sampling
+} twlcdcTouchSample;
+
+/*
+ * Thread safety: all functions may be called from any thread, except where
+ * noted otherwise. Controller access is serialized, including against the
+ * reconfiguration done on suspend and resume, during which reads fail.
+ * Calibration changes and twlcdcTouchGetLatest() never block readers.
+ * Per-stream state (event trackers, smoothing filters, replays) is not
+ * locked, and must only be used from one thread at a time.
+ */
+
 /**
  * @brief Initialize libtwlcdc.
  * Initializing cfg:u and cdc:CHK is required beforehand.
@@ -76,9 +501,23 @@ void twlcdcExit(void);
 
 /**
  * @brief Get the touch calibration data.
+ *
+ * Not thread-safe: the data may change under the caller if another thread
+ * sets the calibration. Use twlcdcTouchCopyCalibration() in that case.
+ *
+ * @return Pointer to the library's calibration data. Do not modify it;
+ * use twlcdcTouchSetCalibration() instead.
  */
 twlcdcTouchCalibration *twlcdcTouchGetCalibration(void);
 
+/**
+ * @brief Get a consistent copy of the touch calibration data, even while
+ * another thread may set it.
+ *
+ * @param out Touch calibration data output.
+ */
+void twlcdcTouchCopyCalibration(twlcdcTouchCalibration *out);
+
 /**
  * @brief Set the touch calibration data.
  *
@@ -90,6 +529,77 @@ twlcdcTouchCalibration *twlcdcTouchGetCalibration(void);
  */
 void twlcdcTouchSetCalibration(const twlcdcTouchCalibration *in);
 
+/**
+ * @brief Set the touch calibration from a set of reference points.
+ *
+ * Unlike twlcdcTouchSetCalibration(), this fits a full affine transform,
+ * correcting for panels which are rotated or sheared relative to the
+ * screen. The points must not all lie on one line.
+ *
+ * This only affects the library, and is not reflected by
+ * twlcdcTouchGetCalibration() or twlcdcTouchCopyCalibration().
+ *
+ * @param points Calibration points.
+ * @param count Number of calibration points; 3 to 9.
+ * @return true Calibration set.
+ * @return false Invalid or degenerate set of points.
+ */
+bool twlcdcTouchSetCalibrationPoints(const twlcdcCalibrationPoint *points, size_t count);
+
+/**
+ * @brief Select a predefined touch screen controller conversion profile.
+ *
+ * Equivalent to calling twlcdcSetTscConfig() with the profile's settings.
+ *
+ * @param profile Profile to select.
+ * @return true Profile selected.
+ * @return false Invalid profile.
+ */
+bool twlcdcSetProfile(twlcdcProfile profile);
+
+/**
+ * @brief Get the touch screen controller conversion settings.
+ */
+void twlcdcGetTscConfig(twlcdcTscConfig* config);
+
+/**
+ * @brief Set the touch screen controller conversion settings.
+ *
+ * If the library is initialized, the controller is reprogrammed
+ * immediately; otherwise, the settings are applied on initialization.
+ * They are also kept across suspend and resume.
+ *
+ * @param config Conversion settings to set. The data is copied.
+ */
+void twlcdcSetTscConfig(const twlcdcTscConfig* config);
+
+/**
+ * @brief Convert raw touch positions to screen positions using the
+ * current calibration.
+ *
+ * For each position, rawx and rawy are converted into px and py, exactly
+ * as twlcdcTouchRead() would with smoothing disabled; other fields are
+ * copied as-is. The controller is not accessed.
+ *
+ * @param in Input positions.
+ * @param out Output positions; may be the same array as in.
+ * @param count Number of positions.
+ */
+void twlcdcTouchConvertBatch(const twlcdcTouchPosition* in, twlcdcTouchPosition* out, size_t count);
+
+/**
+ * @brief Set the filter used to reduce the samples of each reading.
+ *
+ * The median and trimmed mean filters discard outliers, such as the
+ * inaccurate conversions which occur as the pen touches down or lifts.
+ *
+ * @param filter Filter to use.
+ * @param maxSpread For TWLCDC_FILTER_REJECT_SPREAD, the largest allowed
+ * difference between raw X or Y samples; readings over it are reported as
+ * failures. Ignored by other filters.
+ */
+void twlcdcTouchSetFilter(twlcdcFilter filter, u16 maxSpread);
+
 /**
  * @brief Check if the touch screen controller is sensing pen input.
  * 
@@ -107,6 +617,572 @@ bool twlcdcTouchPenDown(void);
  */
 bool twlcdcTouchRead(twlcdcTouchPosition* pos);
 
+/**
+ * @brief Read the individual sample sets held by the controller's data
+ * buffer, instead of their filtered average.
+ *
+ * All sample sets come from a single controller read. Invalid sets are
+ * skipped; the rest are returned oldest first, calibrated but not smoothed.
+ *
+ * @param out Position output array.
+ * @param max Size of the output array; at most TWLCDC_TOUCH_SAMPLES_PER_READ
+ * positions are returned. If 0, the controller is not accessed.
+ * @return Number of positions read; 0 if the pen is up or on read failure.
+ */
+size_t twlcdcTouchReadSamples(twlcdcTouchPosition* out, size_t max);
+
+/**
+ * @brief Get the most recent touch state read by the library, without
+ * accessing the controller.
+ *
+ * A failed read or pen-up check is published as a pen-up sample, which
+ * keeps the last pen-down position.
+ *
+ * @param sample Sample output; penDown is clear if nothing was read yet.
+ * @return true The pen was down at the most recent read.
+ * @return false The pen was up, the read failed or nothing was read yet.
+ */
+bool twlcdcTouchGetLatest(twlcdcTouchSample* sample);
+
+/**
+ * @brief Read touch screen position data, including pressure.
+ *
+ * @param pos Extended touch screen position data pointer.
+ * @return true Data read successfully.
+ * @return false Data read failure.
+ */
+bool twlcdcTouchReadEx(twlcdcTouchPositionEx* pos);
+
+/**
+ * @brief Get the pressure scaling model.
+ */
+void twlcdcTouchGetPressureModel(twlcdcPressureModel* model);
+
+/**
+ * @brief Set the pressure scaling model.
+ *
+ * As the touch resistance for a given contact varies between panels,
+ * this allows tuning the pressure output to a specific device.
+ *
+ * @param model Pressure model to set. The data is copied.
+ */
+void twlcdcTouchSetPressureModel(const twlcdcPressureModel* model);
+
+/**
+ * @brief Enable or disable self-tuning pressure tracking.
+ *
+ * While enabled, every twlcdcTouchReadEx() call updates the tracker and
+ * reports the normalized pressure in the level field.
+ *
+ * @param tracker Initial tracker state, e.g. from twlcdcPressureTrackerInit()
+ * or a previous run; NULL to disable. The data is copied.
+ */
+void twlcdcTouchSetPressureTracking(const twlcdcPressureTracker* tracker);
+
+/**
+ * @brief Get the current self-tuning pressure tracker state, e.g. to save it.
+ *
+ * @param tracker Tracker state output.
+ * @return true Pressure tracking is enabled.
+ * @return false Pressure tracking is disabled.
+ */
+bool twlcdcTouchGetPressureTracking(twlcdcPressureTracker* tracker);
+
+/**
+ * @brief Initialize a self-tuning pressure tracker with no samples seen.
+ */
+void twlcdcPressureTrackerInit(twlcdcPressureTracker *tracker);
+
+/**
+ * @brief Feed a touch resistance sample to a pressure tracker.
+ *
+ * @param tracker Pressure tracker.
+ * @param resistance Touch resistance, as in twlcdcTouchPositionEx; 0 is ignored.
+ */
+void twlcdcPressureTrackerUpdate(twlcdcPressureTracker *tracker, u32 resistance);
+
+/**
+ * @brief Normalize a touch resistance with a pressure tracker.
+ *
+ * @param tracker Pressure tracker.
+ * @param resistance Touch resistance, as in twlcdcTouchPositionEx.
+ * @return Pressure, 0 (lightest) to 0x10000 (firmest); 0 if not measurable.
+ */
+u32 twlcdcPressureTrackerNormalize(const twlcdcPressureTracker *tracker, u32 resistance);
+
+/// Size of a saved settings blob, in bytes.
+#define TWLCDC_SETTINGS_SIZE 96
+
+/**
+ * @brief Save the current calibration and tuning settings to a memory buffer.
+ *
+ * The blob holds the calibration and screen transform, filter, TSC
+ * configuration, pressure model and pressure tracker state, along with
+ * a version and a checksum.
+ *
+ * @param buffer Output buffer.
+ * @param size Output buffer size; at least TWLCDC_SETTINGS_SIZE.
+ * @return Number of bytes written; 0 if the buffer is too small.
+ */
+size_t twlcdcSettingsSave(void* buffer, size_t size);
+
+/**
+ * @brief Restore calibration and tuning settings from a memory buffer.
+ *
+ * If called before twlcdcInit(), twlcdcInit() uses the restored
+ * calibration instead of reading it from the config service.
+ *
+ * @param buffer Settings blob, from twlcdcSettingsSave().
+ * @param size Settings blob size.
+ * @return true Settings restored.
+ * @return false Blob invalid, corrupted, or of a different version; nothing was changed.
+ */
+bool twlcdcSettingsLoad(const void* buffer, size_t size);
+
+/**
+ * @brief Save the current calibration and tuning settings to a file.
+ *
+ * @param file File to write to, opened in binary mode.
+ * @return true Settings saved.
+ * @return false Write error.
+ */
+bool twlcdcSettingsSaveFile(FILE* file);
+
+/**
+ * @brief Restore calibration and tuning settings from a file.
+ *
+ * @param file File to read from, opened in binary mode.
+ * @return true Settings restored.
+ * @return false Read error, or invalid blob; nothing was changed.
+ */
+bool twlcdcSettingsLoadFile(FILE* file);
+
+/**
+ * @brief Check for pen input and read the touch screen position at once.
+ *
+ * This replaces a twlcdcTouchPenDown() + twlcdcTouchRead() pair while
+ * using fewer cdc:CHK IPC round-trips.
+ *
+ * @param pos Touch screen position data pointer.
+ * @param mode Pen state detection mode.
+ * @return true Pen down, position read successfully.
+ * @return false Pen up, or data read failure.
+ */
+bool twlcdcTouchPoll(twlcdcTouchPosition* pos, twlcdcPollMode mode);
+
+/**
+ * @brief Check for pen input and read the extended touch screen position at once.
+ *
+ * This replaces a twlcdcTouchPenDown() + twlcdcTouchReadEx() pair, with the
+ * same IPC cost as twlcdcTouchPoll().
+ *
+ * @param pos Extended touch screen position data pointer.
+ * @param mode Pen state detection mode.
+ * @return true Pen down, position read successfully.
+ * @return false Pen up, or data read failure.
+ */
+bool twlcdcTouchPollEx(twlcdcTouchPositionEx* pos, twlcdcPollMode mode);
+
+/**
+ * @brief Set the touch screen controller register backend.
+ *
+ * This should be done before twlcdcInit(), or after twlcdcExit(), so
+ * that the controller is configured and restored through the same backend.
+ *
+ * @param backend Backend to use; the structure is copied. NULL restores
+ * the default cdc:CHK backend.
+ */
+void twlcdcSetBackend(const twlcdcBackend* backend);
+
+/**
+ * @brief Get library statistics.
+ *
+ * Statistics are only collected if the library was built with
+ * TWLCDC_STATS defined (make TWLCDC_STATS=1); otherwise, this clears the
+ * output and returns false.
+ *
+ * @param stats Statistics output.
+ * @return true Statistics returned.
+ * @return false Statistics collection not compiled in.
+ */
+bool twlcdcGetStats(twlcdcStats *stats);
+
+/**
+ * @brief Reset library statistics.
+ */
+void twlcdcResetStats(void);
+
+/**
+ * @brief Start capturing raw touch data to a file.
+ *
+ * Every touch data buffer read by the library, valid or not, is recorded
+ * with its system tick in a compact binary format. Records are buffered
+ * in memory and written out in blocks. If a block cannot be written, the
+ * capture stops there, and twlcdcCaptureStop() reports the failure.
+ *
+ * @param file File to write to, opened in binary mode. It is not closed
+ * by the library.
+ * @return true Capture started.
+ * @return false Capture already running, or the header could not be written.
+ */
+bool twlcdcCaptureStart(FILE *file);
+
+/**
+ * @brief Stop capturing raw touch data, flushing any buffered records.
+ *
+ * @return true All records were written, or no capture was running.
+ * @return false A write failed; the file holds the records up to the
+ * failed block.
+ */
+bool twlcdcCaptureStop(void);
+
+/**
+ * @brief Prepare to replay a capture made with twlcdcCaptureStart().
+ *
+ * @param replay Replay state to initialize.
+ * @param data Capture file contents; must remain valid during the replay.
+ * @param size Capture file size, in bytes.
+ * @return true Capture accepted.
+ * @return false Not a capture, or unsupported capture version.
+ */
+bool twlcdcReplayInit(twlcdcReplay *replay, const void *data, size_t size);
+
+/**
+ * @brief Create a register backend which plays back a capture.
+ *
+ * Each touch data buffer read returns the next captured record; once the
+ * capture is exhausted, the pen reads as up. Register writes are ignored.
+ * Samples are timestamped with the captured ticks, so that anything timed
+ * from them (smoothing, event debouncing, gestures) replays identically.
+ * Install the result with twlcdcSetBackend().
+ *
+ * @param replay Replay state; must remain valid while the backend is in use.
+ * @param backend Backend output.
+ */
+void twlcdcReplayBackend(twlcdcReplay *replay, twlcdcBackend *backend);
+
+/**
+ * @brief Get the number of register backend round-trips made by the library so far.
+ */
+u32 twlcdcGetIpcCount(void);
+
+/**
+ * @brief Set up adaptive smoothing of twlcdcTouchRead() output.
+ *
+ * @param config Smoothing configuration, copied; NULL disables smoothing.
+ */
+void twlcdcTouchSetSmoothing(const twlcdcSmootherConfig *config);
+
+/**
+ * @brief Initialize an adaptive smoothing filter.
+ *
+ * @param smoother Filter to initialize.
+ * @param config Filter configuration. The data is copied.
+ */
+void twlcdcSmootherInit(twlcdcSmoother *smoother, const twlcdcSmootherConfig *config);
+
+/**
+ * @brief Reset an adaptive smoothing filter, e.g. at the start of a stroke.
+ *
+ * Filters are also reset automatically after a 100 millisecond gap
+ * between positions.
+ */
+void twlcdcSmootherReset(twlcdcSmoother *smoother);
+
+/**
+ * @brief Filter a position in place.
+ *
+ * @param smoother Adaptive smoothing filter.
+ * @param x X coordinate, in 16.16 fixed point pixels.
+ * @param y Y coordinate, in 16.16 fixed point pixels.
+ * @param tick System tick at which the position was sampled.
+ */
+void twlcdcSmootherApply(twlcdcSmoother *smoother, s32 *x, s32 *y, u64 tick);
+
+/**
+ * @brief Start resampling a stroke.
+ *
+ * Points are emitted at uniform arc-length intervals, which evens out the
+ * density of input points sampled at a fixed rate.
+ *
+ * @param stroke Stroke resampler state to initialize.
+ * @param arena Output point buffer; no other memory is used.
+ * @param capacity Output point buffer capacity.
+ * @param spacing Distance between output points, in 16.16 fixed point pixels.
+ * @param smoothing Smoothing mode.
+ */
+void twlcdcStrokeBegin(twlcdcStroke *stroke, twlcdcStrokePoint *arena, size_t capacity, s32 spacing, twlcdcStrokeSmoothing smoothing);
+
+/**
+ * @brief Add an input point to a stroke.
+ *
+ * @return true Success.
+ * @return false The output point buffer is full; points were dropped.
+ */
+bool twlcdcStrokeAdd(twlcdcStroke *stroke, const twlcdcStrokePoint *point);
+
+/**
+ * @brief Finish a stroke, emitting any pending points up to the last input point.
+ *
+ * The resampler may then be reused for another stroke, appending to the
+ * same output point buffer.
+ *
+ * @return true Success.
+ * @return false The output point buffer is full; points were dropped.
+ */
+bool twlcdcStrokeEnd(twlcdcStroke *stroke);
+
+/**
+ * @brief Empty the output point buffer of a stroke, e.g. after rendering
+ * its points, without interrupting the stroke.
+ */
+void twlcdcStrokeClear(twlcdcStroke *stroke);
+
+/**
+ * @brief Initialize a pen event tracker.
+ *
+ * @param tracker Tracker to initialize.
+ * @param config Tracker configuration. The data is copied.
+ */
+void twlcdcEventInit(twlcdcEventTracker *tracker, const twlcdcEventConfig *config);
+
+/**
+ * @brief Feed a pen sample to an event tracker.
+ *
+ * Samples must be fed in chronological order. Any events generated are
+ * queued; if the queue is full, the oldest event is discarded.
+ *
+ * @param tracker Event tracker.
+ * @param sample Pen sample, e.g. from twlcdcSamplerDrain().
+ */
+void twlcdcEventFeed(twlcdcEventTracker *tracker, const twlcdcTouchSample *sample);
+
+/**
+ * @brief Let time pass for an event tracker without feeding a sample.
+ *
+ * Queues the TWLCDC_EVENT_UP of a release once it has outlasted the up
+ * debounce time by tick. Needed when samples stop arriving while the pen
+ * is up, as with the background sampler; call it once per frame, after
+ * feeding that frame's samples.
+ *
+ * @param tracker Event tracker.
+ * @param tick Current system tick; not earlier than the last sample fed.
+ */
+void twlcdcEventAdvance(twlcdcEventTracker *tracker, u64 tick);
+
+/**
+ * @brief Sample the touch screen with twlcdcTouchPoll() and feed the
+ * result to an event tracker.
+ *
+ * @param tracker Event tracker.
+ * @param mode Pen state detection mode.
+ */
+void twlcdcEventPoll(twlcdcEventTracker *tracker, twlcdcPollMode mode);
+
+/**
+ * @brief Take the oldest queued event from an event tracker.
+ *
+ * @param tracker Event tracker.
+ * @param event Event output.
+ * @return true Event returned.
+ * @return false No events queued.
+ */
+bool twlcdcEventNext(twlcdcEventTracker *tracker, twlcdcEvent *event);
+
+/**
+ * @brief Initialize a gesture recognizer.
+ *
+ * @param recognizer Recognizer to initialize.
+ * @param config Recognizer configuration. The data is copied.
+ */
+void twlcdcGestureInit(twlcdcGestureRecognizer *recognizer, const twlcdcGestureConfig *config);
+
+/**
+ * @brief Feed a pen sample to a gesture recognizer.
+ *
+ * Samples must be fed in chronological order, including pen-up samples,
+ * as time only advances with them. Any gestures recognized are queued; if
+ * the queue is full, the oldest gesture is discarded.
+ *
+ * @param recognizer Gesture recognizer.
+ * @param sample Pen sample, e.g. from twlcdcSamplerDrain().
+ */
+void twlcdcGestureFeed(twlcdcGestureRecognizer *recognizer, const twlcdcTouchSample *sample);
+
+/**
+ * @brief Let time pass for a gesture recognizer without feeding a sample.
+ *
+ * Taps, swipes and flicks are recognized when the pen is released, once
+ * the release has outlasted the up debounce time. Without this call, that
+ * only happens on the next sample, which may be the next press. Call it
+ * once per frame, after feeding that frame's samples.
+ *
+ * @param recognizer Gesture recognizer.
+ * @param tick Current system tick; not earlier than the last sample fed.
+ */
+void twlcdcGestureAdvance(twlcdcGestureRecognizer *recognizer, u64 tick);
+
+/**
+ * @brief Take the oldest queued gesture from a gesture recognizer.
+ *
+ * @param recognizer Gesture recognizer.
+ * @param gesture Gesture output.
+ * @return true Gesture returned.
+ * @return false No gestures queued.
+ */
+bool twlcdcGestureNext(twlcdcGestureRecognizer *recognizer, twlcdcGesture *gesture);
+
+/**
+ * @brief Initialize a contact classifier.
+ *
+ * @param classifier Classifier to initialize.
+ * @param config Classifier configuration. The data is copied.
+ */
+void twlcdcContactInit(twlcdcContactClassifier *classifier, const twlcdcContactConfig *config);
+
+/**
+ * @brief Classify the sample sets of one read as a single, dual or unstable contact.
+ *
+ * A resistive panel reports the midpoint of two simultaneous contacts;
+ * these are detected as a sudden drop of touch resistance relative to the
+ * single contact baseline, which is established at the start of each press,
+ * and to the last single contact, together with a jump of the position
+ * away from the last single contact. A drop without a jump, as from
+ * pressing harder, or a gradual one, is a single contact.
+ *
+ * @param classifier Contact classifier.
+ * @param samples Sample sets, e.g. from twlcdcTouchReadSamples().
+ * @param count Number of sample sets; 0 if the pen is up.
+ * @param contact Classified contact output.
+ * @return Contact classification.
+ */
+twlcdcContactType twlcdcContactClassify(twlcdcContactClassifier *classifier, const twlcdcTouchPosition *samples, size_t count, twlcdcContact *contact);
+
+/**
+ * @brief Scan for button and touch screen input, replacing hidScanInput().
+ *
+ * Calls hidScanInput(), then samples the touch screen once. Until the
+ * next call, the twlcdcHid* accessors below report this frame's state
+ * without accessing the controller. These functions are meant to be used
+ * from a single thread.
+ *
+ * A single failed read while the pen is down repeats the previous frame's
+ * sample; the pen is released after two consecutive pen-up or failed
+ * reads, one frame later than the controller reports it.
+ */
+void twlcdcHidScanInput(void);
+
+/**
+ * @brief Replacement for hidKeysHeld(), with KEY_TOUCH reported by this library.
+ */
+u32 twlcdcHidKeysHeld(void);
+
+/**
+ * @brief Replacement for hidKeysDown(), with KEY_TOUCH reported by this library.
+ */
+u32 twlcdcHidKeysDown(void);
+
+/**
+ * @brief Replacement for hidKeysUp(), with KEY_TOUCH reported by this library.
+ */
+u32 twlcdcHidKeysUp(void);
+
+/**
+ * @brief Replacement for hidTouchRead().
+ *
+ * @param pos Touch position output; zero while the pen is up.
+ */
+void twlcdcHidTouchRead(touchPosition* pos);
+
+/**
+ * @brief Get the full touch screen sample of the current frame.
+ *
+ * @param pos Touch position output; zero while the pen is up.
+ * @return true Pen down.
+ * @return false Pen up.
+ */
+bool twlcdcHidTouchReadEx(twlcdcTouchPositionEx* pos);
+
+/**
+ * @brief Get the pressure estimate of the current frame, as in twlcdcTouchPositionEx.
+ *
+ * @return Pressure, 16.16 fixed point; 0 while the pen is up.
+ */
+u32 twlcdcHidTouchPressure(void);
+
+/**
+ * @brief Start sampling the touch screen on a background thread.
+ *
+ * Samples are timestamped and stored in a lock-free ring buffer, to be
+ * retrieved with twlcdcSamplerDrain(). While the pen is up, nothing is
+ * recorded except for a single pen-up sample on release.
+ *
+ * @param rate_hz Sampling rate, in Hz.
+ * @param capacity Ring buffer capacity, in samples; rounded up to a power of two.
+ * @return true Sampler started.
+ * @return false Sampler already running, or could not be started.
+ */
+bool twlcdcSamplerStart(u32 rate_hz, u32 capacity);
+
+/**
+ * @brief Stop the background sampler, discarding any undrained samples.
+ *
+ * May be called while another thread drains; it waits for that drain to
+ * finish, and later drains return nothing.
+ */
+void twlcdcSamplerStop(void);
+
+/**
+ * @brief Copy out samples recorded since the last drain.
+ *
+ * Never waits for the sampler thread or for new samples, only for a
+ * concurrent twlcdcSamplerStart() or twlcdcSamplerStop() to finish.
+ * Must only be called from one thread at a time.
+ *
+ * @param buf Output buffer.
+ * @param count Maximum number of samples to copy.
+ * @return The number of samples copied, oldest first.
+ */
+size_t twlcdcSamplerDrain(twlcdcTouchSample *buf, size_t count);
+
+/**
+ * @brief Get and reset the number of samples dropped due to a full ring buffer.
+ */
+u32 twlcdcSamplerDropped(void);
+
+/**
+ * @brief Start watching for pen contact on a background thread.
+ *
+ * The pen state is polled at minIntervalNs while the pen is down; while it
+ * is up, the interval doubles on every poll, up to maxIntervalNs. This lets
+ * idle screens wait for a tap with twlcdcWaitForPen() instead of polling
+ * every frame.
+ *
+ * @param minIntervalNs Polling interval on contact, in nanoseconds.
+ * @param maxIntervalNs Maximum polling interval while idle, in nanoseconds.
+ * @return true Watcher started.
+ * @return false Watcher already running, or could not be started.
+ */
+bool twlcdcPenNotifyStart(u64 minIntervalNs, u64 maxIntervalNs);
+
+/**
+ * @brief Stop watching for pen contact, releasing any twlcdcWaitForPen() callers.
+ */
+void twlcdcPenNotifyStop(void);
+
+/**
+ * @brief Wait until the pen touches the screen.
+ *
+ * Requires twlcdcPenNotifyStart(). Returns immediately if the pen was
+ * down at the last poll; detection latency is up to the current polling
+ * interval.
+ *
+ * @param timeout_ns Timeout, in nanoseconds; negative to wait indefinitely.
+ * @return true The pen is down.
+ * @return false Timed out, or the watcher is not running.
+ */
+bool twlcdcWaitForPen(s64 timeout_ns);
+
 #ifdef __cplusplus
 }
 #endif
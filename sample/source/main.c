@@ -40,6 +40,11 @@ int main(int argc, char **argv) {
     if (twlcdcInit()) {
         initOk = true;
         printf("libtwlcdc initialized!\n\n");
+
+        // Learn this device's pressure range as the screen is used
+        twlcdcPressureTracker tracker;
+        twlcdcPressureTrackerInit(&tracker);
+        twlcdcTouchSetPressureTracking(&tracker);
     } else {
         printf("Could not init libtwlcdc!\n\n");
     }
@@ -59,31 +64,28 @@ int main(int argc, char **argv) {
         C2D_SceneBegin(bottom);
 
         // Print touch data
-        if (initOk && twlcdcTouchPenDown()) {
-            twlcdcTouchPosition tpos;
-            twlcdcTouchRead(&tpos);
-
+        twlcdcTouchPositionEx tpos;
+        if (initOk && twlcdcTouchPollEx(&tpos, TWLCDC_POLL_CHECKED)) {
             printf("\x1b[9;1H");
-            printf("Raw coords: [%d, %d]            \n", tpos.rawx, tpos.rawy);
-            printf("Adj coords: [%d, %d]            \n", tpos.px, tpos.py);
-            printf("Touch Z1Z2: [%d, %d]            \n", tpos.z1, tpos.z2);
+            printf("Raw coords: [%d, %d]            \n", tpos.pos.rawx, tpos.pos.rawy);
+            printf("Adj coords: [%d, %d]            \n", tpos.pos.px, tpos.pos.py);
+            printf("Touch Z1Z2: [%d, %d]            \n", tpos.pos.z1, tpos.pos.z2);
 
-            if (tpos.z1 != 0) {
-                const u32 maxPressure = 0x00DE0000;
+            if (tpos.resistance != 0) {
                 const u32 maxRadius = 128;
 
-                u32 tosend = tpos.rawx * ((tpos.z2 * 4096 / tpos.z1) - 4096);
-                float pressure = (float) maxPressure / (float) tosend * maxRadius;
+                float pressure = tpos.pressure / 65536.0f;
 
-                printf("Resistance: %08lX %lu               \n", tosend, tosend);
+                printf("Resistance: %08lX %lu               \n", tpos.resistance, tpos.resistance);
                 printf("Pressure: %f                  \n", pressure);
+                printf("Level: %f                     \n", tpos.level / 65536.0f);
 
-                if (!isinf(pressure) && pressure > 0) {
+                if (pressure > 0) {
                     u32 circleColor = C2D_Color32(146, 77, 200, 255);
                     u32 maxPixelsPerCircle = 192;
                     float currentPressure = pressure;
                     while (currentPressure > 0) {
-                        C2D_DrawCircleSolid(tpos.px, tpos.py, 0.0f, (currentPressure * currentPressure) / maxRadius, circleColor);
+                        C2D_DrawCircleSolid(tpos.pos.px, tpos.pos.py, 0.0f, (currentPressure * currentPressure) / maxRadius, circleColor);
                         currentPressure -= maxPixelsPerCircle;
                         // Darken circle color.
                         circleColor = ((circleColor >> 1) & 0x7F7F7F) | 0xFF000000;
@@ -0,0 +1,53 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include "backoff.h"
+
+void backoffInit(twlcdcBackoff *backoff, uint64_t minInterval, uint64_t maxInterval) {
+    if (minInterval == 0) {
+        minInterval = 1;
+    }
+    if (maxInterval < minInterval) {
+        maxInterval = minInterval;
+    }
+    backoff->minInterval = minInterval;
+    backoff->maxInterval = maxInterval;
+    backoff->interval = minInterval;
+}
+
+uint64_t backoffNext(twlcdcBackoff *backoff, bool contact) {
+    uint64_t interval = backoff->interval;
+
+    if (contact) {
+        interval = backoff->minInterval;
+    } else if (interval > backoff->maxInterval / 2) {
+        interval = backoff->maxInterval;
+    } else {
+        interval <<= 1;
+    }
+
+    backoff->interval = interval;
+    return interval;
+}
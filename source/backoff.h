@@ -0,0 +1,44 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_BACKOFF_H__
+#define __LIBTWLCDC_BACKOFF_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Polling interval scheduler: the interval doubles on every idle poll, up
+// to maxInterval, and snaps back to minInterval on contact. Pure state, so
+// any time unit can be used.
+typedef struct twlcdcBackoff {
+    uint64_t minInterval;
+    uint64_t maxInterval;
+    uint64_t interval;
+} twlcdcBackoff;
+
+void backoffInit(twlcdcBackoff *backoff, uint64_t minInterval, uint64_t maxInterval);
+uint64_t backoffNext(twlcdcBackoff *backoff, bool contact);
+
+#endif /* __LIBTWLCDC_BACKOFF_H__ */
@@ -29,16 +29,77 @@
 
 ---------------------------------------------------------------------------------*/
 
+#include <string.h>
 #include <3ds.h>
 #include "twlcdc.h"
 #include "codec_internal.h"
+#include "filter.h"
+#include "stats.h"
+#include "trace.h"
+
+//---------------------------------------------------------------------------------
+static Result cdcChkRead(void* userdata, u8 bank, u8 reg, void* data, size_t size) {
+//---------------------------------------------------------------------------------
+
+    return CDCCHK_ReadRegisters1(bank, reg, data, size);
+}
+
+//---------------------------------------------------------------------------------
+static Result cdcChkWrite(void* userdata, u8 bank, u8 reg, const void* data, size_t size) {
+//---------------------------------------------------------------------------------
+
+    return CDCCHK_WriteRegisters1(bank, reg, data, size);
+}
+
+//---------------------------------------------------------------------------------
+static Result cdcChkReadCtr(void* userdata, u8 page, u8 reg, void* data, size_t size) {
+//---------------------------------------------------------------------------------
+
+    return CDCCHK_ReadRegisters2(page, reg, data, size);
+}
+
+//---------------------------------------------------------------------------------
+static Result cdcChkWriteCtr(void* userdata, u8 page, u8 reg, const void* data, size_t size) {
+//---------------------------------------------------------------------------------
+
+    return CDCCHK_WriteRegisters2(page, reg, data, size);
+}
+
+static const twlcdcBackend cdcChkBackend = { cdcChkRead, cdcChkWrite, NULL, NULL, cdcChkReadCtr, cdcChkWriteCtr };
+static twlcdcBackend cdcBackend = { cdcChkRead, cdcChkWrite, NULL, NULL, cdcChkReadCtr, cdcChkWriteCtr };
+
+//---------------------------------------------------------------------------------
+void cdcSetBackend(const twlcdcBackend* backend) {
+//---------------------------------------------------------------------------------
+
+    cdcBackend = backend != NULL ? *backend : cdcChkBackend;
+}
+
+//---------------------------------------------------------------------------------
+u64 cdcGetTick(void) {
+//---------------------------------------------------------------------------------
+
+    return cdcBackend.getTick != NULL ? cdcBackend.getTick(cdcBackend.userdata) : svcGetSystemTick();
+}
+
+// Every register access is an IPC round-trip on the default backend; count them.
+static u32 cdcIpcCount;
+
+//---------------------------------------------------------------------------------
+u32 cdcGetIpcCount(void) {
+//---------------------------------------------------------------------------------
+
+    return cdcIpcCount;
+}
 
 //---------------------------------------------------------------------------------
 static inline u8 cdcReadReg(u8 bank, u8 reg) {
 //---------------------------------------------------------------------------------
 
     u8 result;
-    CDCCHK_ReadRegisters1(bank, reg, &result, 1);
+    cdcIpcCount++;
+    STATS_IPC(bank);
+    cdcBackend.readRegisters(cdcBackend.userdata, bank, reg, &result, 1);
     return result;
 }
 
@@ -46,14 +107,18 @@ static inline u8 cdcReadReg(u8 bank, u8 reg) {
 static inline void cdcReadRegArray(u8 bank, u8 reg, void* data, u8 size) {
 //---------------------------------------------------------------------------------
 
-    CDCCHK_ReadRegisters1(bank, reg, data, size);
+    cdcIpcCount++;
+    STATS_IPC(bank);
+    cdcBackend.readRegisters(cdcBackend.userdata, bank, reg, data, size);
 }
 
 //---------------------------------------------------------------------------------
 static inline void cdcWriteReg(u8 bank, u8 reg, u8 value) {
 //---------------------------------------------------------------------------------
 
-    CDCCHK_WriteRegisters1(bank, reg, &value, 1);
+    cdcIpcCount++;
+    STATS_IPC(bank);
+    cdcBackend.writeRegisters(cdcBackend.userdata, bank, reg, &value, 1);
 }
 
 //---------------------------------------------------------------------------------
@@ -67,62 +132,211 @@ static inline void cdcWriteRegMask(u8 bank, u8 reg, u8 mask, u8 value) {
 static inline void cdcWriteRegArray(u8 bank, u8 reg, const void* data, u8 size) {
 //---------------------------------------------------------------------------------
 
-    CDCCHK_WriteRegisters1(bank, reg, data, size);
+    cdcIpcCount++;
+    STATS_IPC(bank);
+    cdcBackend.writeRegisters(cdcBackend.userdata, bank, reg, data, size);
+}
+
+// thanks, Sono!
+//---------------------------------------------------------------------------------
+bool cdcSetCtrReadMode(bool enabled) {
+//---------------------------------------------------------------------------------
+
+    u8 value;
+
+    if (cdcBackend.readCtrRegisters == NULL || cdcBackend.writeCtrRegisters == NULL) {
+        // no CTR-mode codec behind this backend; nothing to hand over
+        return true;
+    }
+
+    cdcIpcCount++;
+    STATS_IPC(CDC_CTR_PAGE);
+    if (R_FAILED(cdcBackend.readCtrRegisters(cdcBackend.userdata, CDC_CTR_PAGE, CDC_CTR_READ_MODE, &value, 1))) {
+        return false;
+    }
+    if (enabled) value |= CDC_CTR_READ_MODE_ENABLE; else value &= ~CDC_CTR_READ_MODE_ENABLE;
+    cdcIpcCount++;
+    STATS_IPC(CDC_CTR_PAGE);
+    if (R_FAILED(cdcBackend.writeCtrRegisters(cdcBackend.userdata, CDC_CTR_PAGE, CDC_CTR_READ_MODE, &value, 1))) {
+        return false;
+    }
+    return true;
+}
+
+// Shadow copy of CDC_TOUCHCNT registers 0x02 to 0x12, plus the values to
+// restore on exit. The whole range is read in one transfer; writes are
+// then applied to the shadow and flushed as a few contiguous ranges,
+// instead of a read-modify-write round-trip per register field.
+#define CDC_SHADOW_FIRST 0x02
+#define CDC_SHADOW_LAST  0x12
+
+static u8 cdcShadow[CDC_SHADOW_LAST + 1];
+static u8 cdcBackup[CDC_SHADOW_LAST + 1];
+
+static twlcdcTscConfig cdcTscConfig = {
+    .clockDivider = 3,
+    .conversionMode = 0x8B,
+    .prechargeTime = 4,
+    .senseTime = 6,
+    .stabilizationTime = 4,
+    .bufferTrigger = 5,
+    .scanTimer = 0xA0,
+    .scanTimerClock = 0
+};
+
+//---------------------------------------------------------------------------------
+static void cdcShadowLoad(void) {
+//---------------------------------------------------------------------------------
+
+    cdcReadRegArray(CDC_TOUCHCNT, CDC_SHADOW_FIRST, &cdcShadow[CDC_SHADOW_FIRST], CDC_SHADOW_LAST - CDC_SHADOW_FIRST + 1);
+}
+
+//---------------------------------------------------------------------------------
+static void cdcShadowFlush(const u8* regs, u8 reg, u8 size) {
+//---------------------------------------------------------------------------------
+
+    cdcWriteRegArray(CDC_TOUCHCNT, reg, &regs[reg], size);
+}
+
+//---------------------------------------------------------------------------------
+static inline void cdcShadowMask(u8* regs, u8 reg, u8 mask, u8 value) {
+//---------------------------------------------------------------------------------
+
+    regs[reg] = (regs[reg] & (~mask)) | (value & mask);
+}
+
+//---------------------------------------------------------------------------------
+static void cdcTouchApplyConfig(u8* regs) {
+//---------------------------------------------------------------------------------
+
+    const twlcdcTscConfig *cfg = &cdcTscConfig;
+
+    cdcShadowMask(regs, 0x02, 0x18, cfg->clockDivider<<3);
+    regs[0x03] = cfg->conversionMode;
+    cdcShadowMask(regs, 0x04, 0x07, cfg->senseTime<<0);
+    cdcShadowMask(regs, 0x04, 0x70, cfg->prechargeTime<<4);
+    cdcShadowMask(regs, 0x05, 0x07, cfg->stabilizationTime<<0);
+    cdcShadowMask(regs, 0x0E, 0x38, cfg->bufferTrigger<<3);
+    cdcShadowMask(regs, 0x0E, 0x40, 0<<6);
+    cdcShadowMask(regs, 0x0E, 0x80, 1<<7);
+    regs[0x0F] = cfg->scanTimer;
+    cdcShadowMask(regs, 0x12, 0x07, cfg->scanTimerClock<<0);
+}
+
+//---------------------------------------------------------------------------------
+static bool cdcTouchIsConfigured(void) {
+//---------------------------------------------------------------------------------
+
+    u8 target[CDC_SHADOW_LAST + 1];
+
+    memcpy(target, cdcShadow, sizeof(target));
+    cdcTouchApplyConfig(target);
+
+    return memcmp(&target[0x02], &cdcShadow[0x02], 4) == 0
+        && ((target[0x0E] ^ cdcShadow[0x0E]) & 0xF8) == 0
+        && target[0x0F] == cdcShadow[0x0F]
+        && target[0x12] == cdcShadow[0x12];
+}
+
+//---------------------------------------------------------------------------------
+static void cdcTouchConfigure(void) {
+//---------------------------------------------------------------------------------
+
+    // Stop buffer mode while reconfiguring; only restart it once
+    // everything else has been written.
+    cdcShadowMask(cdcShadow, 0x0E, 0x80, 0<<7);
+    cdcShadowFlush(cdcShadow, 0x0E, 1);
+
+    cdcTouchApplyConfig(cdcShadow);
+    cdcShadowMask(cdcShadow, 0x0E, 0x80, 0<<7);
+    cdcShadowFlush(cdcShadow, 0x02, 4);
+    cdcShadowFlush(cdcShadow, 0x0E, 2);
+    cdcShadowFlush(cdcShadow, 0x12, 1);
+
+    cdcShadowMask(cdcShadow, 0x0E, 0x80, 1<<7);
+    cdcShadowFlush(cdcShadow, 0x0E, 1);
+}
+
+//---------------------------------------------------------------------------------
+void cdcTouchGetConfig(twlcdcTscConfig* config) {
+//---------------------------------------------------------------------------------
+
+    *config = cdcTscConfig;
 }
 
-static struct {
-    uint8_t reg02;
-    uint8_t reg03;
-    uint8_t reg04;
-    uint8_t reg05;
-    uint8_t reg0E;
-    uint8_t reg0F;
-    uint8_t reg12;
-} twlcdcBackup;
+//---------------------------------------------------------------------------------
+void cdcTouchSetConfig(const twlcdcTscConfig* config, bool apply) {
+//---------------------------------------------------------------------------------
+
+    cdcTscConfig = *config;
+    if (apply) {
+        cdcTouchConfigure();
+    }
+}
 
 //---------------------------------------------------------------------------------
 void cdcTouchInit(void) {
 //---------------------------------------------------------------------------------
 
-    twlcdcBackup.reg02 = cdcReadReg(CDC_TOUCHCNT, 0x02);
-    twlcdcBackup.reg03 = cdcReadReg(CDC_TOUCHCNT, 0x03);
-    twlcdcBackup.reg04 = cdcReadReg(CDC_TOUCHCNT, 0x04);
-    twlcdcBackup.reg05 = cdcReadReg(CDC_TOUCHCNT, 0x05);
-    twlcdcBackup.reg0E = cdcReadReg(CDC_TOUCHCNT, 0x0E);
-    twlcdcBackup.reg0F = cdcReadReg(CDC_TOUCHCNT, 0x0F);
-    twlcdcBackup.reg12 = cdcReadReg(CDC_TOUCHCNT, 0x12);
+    cdcShadowLoad();
+    memcpy(cdcBackup, cdcShadow, sizeof(cdcBackup));
+    cdcTouchConfigure();
+}
 
-    cdcWriteRegMask(CDC_TOUCHCNT, 0x0E, 0x80, 0<<7);
-    cdcWriteRegMask(CDC_TOUCHCNT, 0x02, 0x18, 3<<3);
-    cdcWriteReg    (CDC_TOUCHCNT, 0x0F, 0xA0);
-    cdcWriteRegMask(CDC_TOUCHCNT, 0x0E, 0x38, 5<<3);
-    cdcWriteRegMask(CDC_TOUCHCNT, 0x0E, 0x40, 0<<6);
-    cdcWriteReg    (CDC_TOUCHCNT, 0x03, 0x8B);
-    cdcWriteRegMask(CDC_TOUCHCNT, 0x05, 0x07, 4<<0);
-    cdcWriteRegMask(CDC_TOUCHCNT, 0x04, 0x07, 6<<0);
-    cdcWriteRegMask(CDC_TOUCHCNT, 0x04, 0x70, 4<<4);
-    cdcWriteRegMask(CDC_TOUCHCNT, 0x12, 0x07, 0<<0);
-    cdcWriteRegMask(CDC_TOUCHCNT, 0x0E, 0x80, 1<<7);
+//---------------------------------------------------------------------------------
+void cdcTouchResume(void) {
+//---------------------------------------------------------------------------------
+
+    cdcShadowLoad();
+    // When waking from sleep, the controller has not been handed back to
+    // the system, and still holds our configuration. In that case, keep
+    // the original backup rather than overwriting it with our own values.
+    if (cdcTouchIsConfigured()) {
+        return;
+    }
+    memcpy(cdcBackup, cdcShadow, sizeof(cdcBackup));
+    cdcTouchConfigure();
 }
 
 //---------------------------------------------------------------------------------
 void cdcTouchExit(void) {
 //---------------------------------------------------------------------------------
 
-    cdcWriteReg(CDC_TOUCHCNT, 0x05, twlcdcBackup.reg05);
-    cdcWriteReg(CDC_TOUCHCNT, 0x04, twlcdcBackup.reg04);
-    cdcWriteReg(CDC_TOUCHCNT, 0x12, twlcdcBackup.reg12);
-    cdcWriteReg(CDC_TOUCHCNT, 0x0F, twlcdcBackup.reg0F);
-    cdcWriteReg(CDC_TOUCHCNT, 0x03, twlcdcBackup.reg03);
-    cdcWriteReg(CDC_TOUCHCNT, 0x02, twlcdcBackup.reg02);
-    cdcWriteReg(CDC_TOUCHCNT, 0x0E, twlcdcBackup.reg0E);
+    cdcShadowFlush(cdcBackup, 0x02, 4);
+    cdcShadowFlush(cdcBackup, 0x0F, 1);
+    cdcShadowFlush(cdcBackup, 0x12, 1);
+    cdcShadowFlush(cdcBackup, 0x0E, 1);
+    memcpy(cdcShadow, cdcBackup, sizeof(cdcShadow));
+}
+
+static twlcdcFilter cdcFilter = TWLCDC_FILTER_MEAN;
+static u16 cdcMaxSpread;
+
+//---------------------------------------------------------------------------------
+void cdcTouchSetFilter(twlcdcFilter filter, u16 maxSpread) {
+//---------------------------------------------------------------------------------
+
+    cdcFilter = filter;
+    cdcMaxSpread = maxSpread;
+}
+
+//---------------------------------------------------------------------------------
+void cdcTouchGetFilter(twlcdcFilter* filter, u16* maxSpread) {
+//---------------------------------------------------------------------------------
+
+    *filter = cdcFilter;
+    *maxSpread = cdcMaxSpread;
 }
 
 //---------------------------------------------------------------------------------
 bool cdcTouchPenDown(void) {
 //---------------------------------------------------------------------------------
 
-    return (cdcReadReg(CDC_TOUCHCNT, 0x09) & 0xC0) != 0x40 && !(cdcReadReg(CDC_TOUCHCNT, 0x0E) & 0x02);
+    // Registers 0x09 and 0x0E are fetched in a single transfer.
+    u8 status[0x0E - 0x09 + 1];
+    cdcReadRegArray(CDC_TOUCHCNT, 0x09, status, sizeof(status));
+
+    return (status[0] & 0xC0) != 0x40 && !(status[0x0E - 0x09] & 0x02);
 }
 
 //---------------------------------------------------------------------------------
@@ -131,10 +345,12 @@ bool cdcTouchRead(twlcdcTouchPosition* pos) {
 
     u8 raw[4*2*5];
     u16 arrayX[5], arrayY[5], arrayZ1[5], arrayZ2[5];
-    u32 sumX, sumY, sumZ1, sumZ2;
     int i;
 
     cdcReadRegArray(CDC_TOUCHDATA, 0x01, raw, sizeof(raw));
+    if (traceCapturing) {
+        traceCaptureRecord(raw);
+    }
 
     for (i = 0; i < 5; i ++) {
         arrayX[i]  = (raw[i*2+ 0]<<8) | raw[i*2+ 1];
@@ -142,27 +358,57 @@ bool cdcTouchRead(twlcdcTouchPosition* pos) {
         arrayZ1[i] = (raw[i*2+20]<<8) | raw[i*2+21];
         arrayZ2[i] = (raw[i*2+30]<<8) | raw[i*2+31];
         if ((arrayX[i] & 0xF000) || (arrayY[i] & 0xF000)) {
+            STATS_INVALID();
             pos->rawx = 0;
             pos->rawy = 0;
             return false;
         }
     }
 
-    // TODO: For now we just average all values without removing inaccurate values
-    sumX = 0;
-    sumY = 0;
-    sumZ1 = 0;
-    sumZ2 = 0;
-    for (i = 0; i < 5; i ++) {
-        sumX += arrayX[i];
-        sumY += arrayY[i];
-        sumZ1 += arrayZ1[i];
-        sumZ2 += arrayZ2[i];
+    if (cdcFilter == TWLCDC_FILTER_REJECT_SPREAD
+        && (filterSpread5(arrayX) > cdcMaxSpread || filterSpread5(arrayY) > cdcMaxSpread)) {
+        STATS_INVALID();
+        pos->rawx = 0;
+        pos->rawy = 0;
+        return false;
     }
 
-    pos->rawx = sumX / 5;
-    pos->rawy = sumY / 5;
-    pos->z1 = sumZ1 / 5;
-    pos->z2 = sumZ2 / 5;
+    pos->rawx = filterReduce5(arrayX, cdcFilter);
+    pos->rawy = filterReduce5(arrayY, cdcFilter);
+    pos->z1 = filterReduce5(arrayZ1, cdcFilter);
+    pos->z2 = filterReduce5(arrayZ2, cdcFilter);
     return true;
 }
+
+//---------------------------------------------------------------------------------
+int cdcTouchReadSamples(twlcdcTouchPosition* out, int max) {
+//---------------------------------------------------------------------------------
+
+    u8 raw[4*2*5];
+    int i, count = 0;
+
+    cdcReadRegArray(CDC_TOUCHDATA, 0x01, raw, sizeof(raw));
+    if (traceCapturing) {
+        traceCaptureRecord(raw);
+    }
+
+    // Unlike cdcTouchRead(), each sample set is validated on its own, so
+    // that one bad conversion does not discard the whole buffer.
+    for (i = 0; i < 5 && count < max; i ++) {
+        u16 x = (raw[i*2+ 0]<<8) | raw[i*2+ 1];
+        u16 y = (raw[i*2+10]<<8) | raw[i*2+11];
+        if ((x & 0xF000) || (y & 0xF000)) {
+            continue;
+        }
+        out[count].rawx = x;
+        out[count].rawy = y;
+        out[count].z1 = (raw[i*2+20]<<8) | raw[i*2+21];
+        out[count].z2 = (raw[i*2+30]<<8) | raw[i*2+31];
+        count++;
+    }
+
+    if (count == 0) {
+        STATS_INVALID();
+    }
+    return count;
+}
@@ -69,9 +69,25 @@ enum cdcBanks {
 	CDC_TOUCHDATA	= 0xFC, // TSC data buffer
 };
 
+// CTR-mode codec register holding the TSC read mode, accessed through
+// the backend's CTR register callbacks
+#define CDC_CTR_PAGE              0x67
+#define CDC_CTR_READ_MODE         0x25
+#define CDC_CTR_READ_MODE_ENABLE  BIT(6)
+
+void cdcSetBackend(const twlcdcBackend* backend);
+u64 cdcGetTick(void);
+u32 cdcGetIpcCount(void);
+bool cdcSetCtrReadMode(bool enabled);
+void cdcTouchGetConfig(twlcdcTscConfig* config);
+void cdcTouchSetConfig(const twlcdcTscConfig* config, bool apply);
 void cdcTouchInit(void);
+void cdcTouchResume(void);
 void cdcTouchExit(void);
+void cdcTouchSetFilter(twlcdcFilter filter, u16 maxSpread);
+void cdcTouchGetFilter(twlcdcFilter* filter, u16* maxSpread);
 bool cdcTouchPenDown(void);
 bool cdcTouchRead(twlcdcTouchPosition* pos);
+int cdcTouchReadSamples(twlcdcTouchPosition* out, int max);
 
 #endif /* __LIBTWLCDC_CODEC_INTERNAL_H__ */
@@ -0,0 +1,141 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "pressure.h"
+
+// Dual contact detection on a 4-wire resistive panel.
+//
+// Two simultaneous contacts short out the part of the panel between them,
+// so the controller reports their midpoint with a touch resistance that is
+// well below that of a single contact at the same pressure. Pressing
+// harder also lowers the resistance, but gradually, and leaves the position
+// in place, so a second contact is only reported when a drop relative to
+// both the running single-contact baseline and the last single contact
+// coincides with a jump of the position away from the latter. The relative
+// drop serves as a rough separation estimate.
+
+// the smallest number of valid sample sets for a stable classification
+#define CONTACT_MIN_SAMPLES 3
+// stable samples following the first one during which the baseline
+// follows the resistance without smoothing
+#define CONTACT_SETTLE_SAMPLES 6
+
+static bool contactJumped(const twlcdcContactClassifier *classifier, const twlcdcTouchPosition *pos) {
+    int distance = classifier->config.jumpDistance;
+    int dx = pos->px - classifier->lastSingle.px;
+    int dy = pos->py - classifier->lastSingle.py;
+
+    return dx > distance || dx < -distance || dy > distance || dy < -distance;
+}
+
+void twlcdcContactInit(twlcdcContactClassifier *classifier, const twlcdcContactConfig *config) {
+    memset(classifier, 0, sizeof(twlcdcContactClassifier));
+    classifier->config = *config;
+}
+
+twlcdcContactType twlcdcContactClassify(twlcdcContactClassifier *classifier, const twlcdcTouchPosition *samples, size_t count, twlcdcContact *contact) {
+    const twlcdcContactConfig *config = &classifier->config;
+    u32 px = 0, py = 0, rawx = 0, rawy = 0, z1 = 0, z2 = 0;
+    u16 minX = 0xFFFF, maxX = 0, minY = 0xFFFF, maxY = 0;
+    u64 resistance = 0;
+    bool measurable = true;
+    size_t i;
+
+    memset(contact, 0, sizeof(twlcdcContact));
+
+    if (count == 0) {
+        // pen up; the next press starts with a fresh baseline
+        classifier->primed = false;
+        contact->type = TWLCDC_CONTACT_NONE;
+        return contact->type;
+    }
+
+    for (i = 0; i < count; i++) {
+        u32 r = pressureResistance(samples[i].rawx, samples[i].z1, samples[i].z2);
+        if (r == 0) {
+            measurable = false;
+        }
+        resistance += r;
+        px += samples[i].px;
+        py += samples[i].py;
+        rawx += samples[i].rawx;
+        rawy += samples[i].rawy;
+        z1 += samples[i].z1;
+        z2 += samples[i].z2;
+        if (samples[i].rawx < minX) minX = samples[i].rawx;
+        if (samples[i].rawx > maxX) maxX = samples[i].rawx;
+        if (samples[i].rawy < minY) minY = samples[i].rawy;
+        if (samples[i].rawy > maxY) maxY = samples[i].rawy;
+    }
+
+    contact->pos.px = px / count;
+    contact->pos.py = py / count;
+    contact->pos.rawx = rawx / count;
+    contact->pos.rawy = rawy / count;
+    contact->pos.z1 = z1 / count;
+    contact->pos.z2 = z2 / count;
+    contact->resistance = resistance / count;
+
+    if (count < CONTACT_MIN_SAMPLES || !measurable
+        || maxX - minX > config->maxSpread || maxY - minY > config->maxSpread) {
+        contact->type = TWLCDC_CONTACT_UNSTABLE;
+    } else if (!classifier->primed || classifier->settling > 0) {
+        // The first stable samples of a press are assumed to be a single
+        // contact, whose resistance falls quickly as it firms up.
+        if (!classifier->primed) {
+            classifier->primed = true;
+            classifier->settling = CONTACT_SETTLE_SAMPLES;
+        } else {
+            classifier->settling--;
+        }
+        classifier->baseline = contact->resistance;
+        contact->type = TWLCDC_CONTACT_SINGLE;
+    } else if (((u64) contact->resistance << 16) < (u64) classifier->baseline * config->dualRatio
+        && ((u64) contact->resistance << 16) < (u64) classifier->lastResistance * config->dualRatio
+        && contactJumped(classifier, &contact->pos)) {
+        u32 drop = classifier->baseline - contact->resistance;
+        contact->type = TWLCDC_CONTACT_DUAL;
+        contact->separation = ((u64) drop * config->separationScale) / classifier->baseline;
+    } else {
+        // track pressure changes of the single contact
+        s64 delta = (s64) contact->resistance - classifier->baseline;
+        classifier->baseline += (delta * config->baselineWeight) >> 16;
+        contact->type = TWLCDC_CONTACT_SINGLE;
+    }
+
+    if (contact->type == TWLCDC_CONTACT_SINGLE) {
+        classifier->lastSingle = contact->pos;
+        classifier->lastResistance = contact->resistance;
+    } else if (config->jumpDistance != 0 && classifier->primed && contactJumped(classifier, &contact->pos)) {
+        // hold the last single contact position instead of jumping to the midpoint
+        contact->pos = classifier->lastSingle;
+        contact->suppressed = true;
+    }
+
+    return contact->type;
+}
@@ -0,0 +1,110 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "pen.h"
+
+static void eventPush(twlcdcEventTracker *tracker, twlcdcEventType type, u64 tick) {
+    twlcdcEvent *event = &tracker->queue[penQueueAppend(&tracker->head, &tracker->count, TWLCDC_EVENT_QUEUE_SIZE)];
+
+    event->type = type;
+    event->tick = tick;
+    event->px = tracker->lastX;
+    event->py = tracker->lastY;
+}
+
+void twlcdcEventInit(twlcdcEventTracker *tracker, const twlcdcEventConfig *config) {
+    memset(tracker, 0, sizeof(twlcdcEventTracker));
+    tracker->config = *config;
+}
+
+void twlcdcEventFeed(twlcdcEventTracker *tracker, const twlcdcTouchSample *sample) {
+    const twlcdcEventConfig *config = &tracker->config;
+
+    switch (tracker->state) {
+    case PEN_STATE_UP:
+        if (!sample->penDown) {
+            break;
+        }
+        tracker->state = PEN_STATE_PENDING_DOWN;
+        tracker->pendingTick = sample->tick;
+        // fall through
+    case PEN_STATE_PENDING_DOWN:
+        if (!sample->penDown) {
+            // contact bounce; the press is discarded
+            tracker->state = PEN_STATE_UP;
+        } else if (sample->tick - tracker->pendingTick >= config->downDebounce) {
+            tracker->state = PEN_STATE_DOWN;
+            tracker->lastX = sample->pos.px;
+            tracker->lastY = sample->pos.py;
+            eventPush(tracker, TWLCDC_EVENT_DOWN, tracker->pendingTick);
+        }
+        break;
+    case PEN_STATE_DOWN:
+    case PEN_STATE_PENDING_UP:
+        switch (penReleaseFeed(&tracker->state, &tracker->pendingTick, config->upDebounce, sample)) {
+        case PEN_HELD: {
+            int dx = sample->pos.px - tracker->lastX;
+            int dy = sample->pos.py - tracker->lastY;
+            if (dx < 0) dx = -dx;
+            if (dy < 0) dy = -dy;
+            if (dx > config->moveThreshold || dy > config->moveThreshold) {
+                tracker->lastX = sample->pos.px;
+                tracker->lastY = sample->pos.py;
+                eventPush(tracker, TWLCDC_EVENT_MOVE, sample->tick);
+            }
+            break;
+        }
+        case PEN_RELEASED:
+            eventPush(tracker, TWLCDC_EVENT_UP, tracker->pendingTick);
+            break;
+        case PEN_RELEASED_PRESSED:
+            eventPush(tracker, TWLCDC_EVENT_UP, tracker->pendingTick);
+            twlcdcEventFeed(tracker, sample);
+            break;
+        case PEN_RELEASING:
+            break;
+        }
+        break;
+    }
+}
+
+void twlcdcEventAdvance(twlcdcEventTracker *tracker, u64 tick) {
+    if (penReleaseAdvance(&tracker->state, tracker->pendingTick, tracker->config.upDebounce, tick)) {
+        eventPush(tracker, TWLCDC_EVENT_UP, tracker->pendingTick);
+    }
+}
+
+bool twlcdcEventNext(twlcdcEventTracker *tracker, twlcdcEvent *event) {
+    u8 slot;
+
+    if (!penQueueTake(&tracker->head, &tracker->count, TWLCDC_EVENT_QUEUE_SIZE, &slot)) {
+        return false;
+    }
+    *event = tracker->queue[slot];
+    return true;
+}
@@ -0,0 +1,71 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include "filter.h"
+
+// The kernels below are written as min/max sequences rather than
+// branches, so that they compile down to conditional instructions.
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#define SORT2(a, b) do { u16 lo_ = MIN(a, b); b = MAX(a, b); a = lo_; } while (0)
+
+// 9-comparator sorting network for five elements.
+static inline void sort5(u16 *v) {
+    u16 a = v[0], b = v[1], c = v[2], d = v[3], e = v[4];
+
+    SORT2(a, b); SORT2(d, e); SORT2(c, e);
+    SORT2(c, d); SORT2(b, e); SORT2(a, d);
+    SORT2(a, c); SORT2(b, d); SORT2(b, c);
+
+    v[0] = a; v[1] = b; v[2] = c; v[3] = d; v[4] = e;
+}
+
+u16 filterReduce5(const u16 *v, twlcdcFilter filter) {
+    u16 s[5];
+
+    switch (filter) {
+    case TWLCDC_FILTER_MEDIAN:
+        s[0] = v[0]; s[1] = v[1]; s[2] = v[2]; s[3] = v[3]; s[4] = v[4];
+        sort5(s);
+        return s[2];
+    case TWLCDC_FILTER_TRIMMED_MEAN:
+        s[0] = v[0]; s[1] = v[1]; s[2] = v[2]; s[3] = v[3]; s[4] = v[4];
+        sort5(s);
+        return ((u32) s[1] + s[2] + s[3]) / 3;
+    case TWLCDC_FILTER_MEAN:
+    case TWLCDC_FILTER_REJECT_SPREAD:
+    default:
+        return ((u32) v[0] + v[1] + v[2] + v[3] + v[4]) / 5;
+    }
+}
+
+u16 filterSpread5(const u16 *v) {
+    u16 lo = MIN(MIN(v[0], v[1]), MIN(v[2], v[3]));
+    u16 hi = MAX(MAX(v[0], v[1]), MAX(v[2], v[3]));
+
+    lo = MIN(lo, v[4]);
+    hi = MAX(hi, v[4]);
+    return hi - lo;
+}
@@ -0,0 +1,36 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_FILTER_H__
+#define __LIBTWLCDC_FILTER_H__
+
+#include "twlcdc.h"
+
+// Reduce the five samples of one TSC buffer channel to a single value.
+u16 filterReduce5(const u16 *v, twlcdcFilter filter);
+// Difference between the largest and smallest of five samples.
+u16 filterSpread5(const u16 *v);
+
+#endif /* __LIBTWLCDC_FILTER_H__ */
@@ -0,0 +1,175 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "pen.h"
+
+// Every sample is processed in constant time, and no history is kept
+// beyond the press start, the last position and a smoothed velocity.
+
+static void gesturePush(twlcdcGestureRecognizer *recognizer, twlcdcGestureType type, u64 tick) {
+    twlcdcGesture *gesture = &recognizer->queue[penQueueAppend(&recognizer->head, &recognizer->count, TWLCDC_GESTURE_QUEUE_SIZE)];
+
+    gesture->type = type;
+    gesture->tick = tick;
+    gesture->px = recognizer->startX;
+    gesture->py = recognizer->startY;
+    gesture->dx = recognizer->lastX - recognizer->startX;
+    gesture->dy = recognizer->lastY - recognizer->startY;
+    gesture->vx = recognizer->vx;
+    gesture->vy = recognizer->vy;
+}
+
+static inline bool gestureWithin(int dx, int dy, int distance) {
+    return dx <= distance && dx >= -distance && dy <= distance && dy >= -distance;
+}
+
+static s32 gestureVelocity(int delta, u64 ticks) {
+    s64 velocity = ((s64) delta << 16) * SYSCLOCK_ARM11 / (s64) ticks;
+
+    return velocity > INT32_MAX ? INT32_MAX : (velocity < INT32_MIN ? INT32_MIN : velocity);
+}
+
+static void gesturePress(twlcdcGestureRecognizer *recognizer, const twlcdcTouchSample *sample) {
+    recognizer->state = PEN_STATE_DOWN;
+    recognizer->moved = false;
+    recognizer->longPressed = false;
+    recognizer->downTick = sample->tick;
+    recognizer->lastTick = sample->tick;
+    recognizer->startX = recognizer->lastX = sample->pos.px;
+    recognizer->startY = recognizer->lastY = sample->pos.py;
+    recognizer->vx = 0;
+    recognizer->vy = 0;
+}
+
+static void gestureMove(twlcdcGestureRecognizer *recognizer, const twlcdcTouchSample *sample) {
+    const twlcdcGestureConfig *config = &recognizer->config;
+    int dx = sample->pos.px - recognizer->lastX;
+    int dy = sample->pos.py - recognizer->lastY;
+    u64 dt = sample->tick - recognizer->lastTick;
+
+    if (dt > 0) {
+        // exponentially weighted moving average of the instantaneous velocity
+        s64 vx = recognizer->vx, vy = recognizer->vy;
+        vx += ((gestureVelocity(dx, dt) - vx) * config->velocityWeight) >> 16;
+        vy += ((gestureVelocity(dy, dt) - vy) * config->velocityWeight) >> 16;
+        recognizer->vx = vx;
+        recognizer->vy = vy;
+    }
+
+    recognizer->lastX = sample->pos.px;
+    recognizer->lastY = sample->pos.py;
+    recognizer->lastTick = sample->tick;
+
+    if (!gestureWithin(recognizer->lastX - recognizer->startX, recognizer->lastY - recognizer->startY, config->tapSlop)) {
+        recognizer->moved = true;
+    }
+    if (!recognizer->moved && !recognizer->longPressed
+        && sample->tick - recognizer->downTick >= config->longPressTicks) {
+        recognizer->longPressed = true;
+        gesturePush(recognizer, TWLCDC_GESTURE_LONG_PRESS, sample->tick);
+    }
+}
+
+static void gestureRelease(twlcdcGestureRecognizer *recognizer, u64 tick) {
+    const twlcdcGestureConfig *config = &recognizer->config;
+
+    if (recognizer->moved) {
+        int dx = recognizer->lastX - recognizer->startX;
+        int dy = recognizer->lastY - recognizer->startY;
+        if (!gestureWithin(dx, dy, config->swipeDistance - 1)) {
+            s64 vx = recognizer->vx >> 8;
+            s64 vy = recognizer->vy >> 8;
+            s64 flick = (s64) config->flickSpeed << 8;
+            gesturePush(recognizer,
+                vx * vx + vy * vy >= flick * flick ? TWLCDC_GESTURE_FLICK : TWLCDC_GESTURE_SWIPE,
+                tick);
+        }
+        recognizer->tapPending = false;
+    } else if (!recognizer->longPressed && tick - recognizer->downTick <= config->tapTicks) {
+        gesturePush(recognizer, TWLCDC_GESTURE_TAP, tick);
+        if (recognizer->tapPending
+            && recognizer->downTick - recognizer->tapTick <= config->doubleTapTicks
+            && gestureWithin(recognizer->startX - recognizer->tapX, recognizer->startY - recognizer->tapY, config->tapSlop)) {
+            gesturePush(recognizer, TWLCDC_GESTURE_DOUBLE_TAP, tick);
+            recognizer->tapPending = false;
+        } else {
+            recognizer->tapPending = true;
+            recognizer->tapTick = tick;
+            recognizer->tapX = recognizer->startX;
+            recognizer->tapY = recognizer->startY;
+        }
+    } else {
+        recognizer->tapPending = false;
+    }
+}
+
+void twlcdcGestureInit(twlcdcGestureRecognizer *recognizer, const twlcdcGestureConfig *config) {
+    memset(recognizer, 0, sizeof(twlcdcGestureRecognizer));
+    recognizer->config = *config;
+}
+
+void twlcdcGestureFeed(twlcdcGestureRecognizer *recognizer, const twlcdcTouchSample *sample) {
+    if (recognizer->state == PEN_STATE_UP) {
+        if (sample->penDown) {
+            gesturePress(recognizer, sample);
+        }
+        return;
+    }
+
+    switch (penReleaseFeed(&recognizer->state, &recognizer->upTick, recognizer->config.upDebounce, sample)) {
+    case PEN_HELD:
+        gestureMove(recognizer, sample);
+        break;
+    case PEN_RELEASED:
+        gestureRelease(recognizer, recognizer->upTick);
+        break;
+    case PEN_RELEASED_PRESSED:
+        gestureRelease(recognizer, recognizer->upTick);
+        gesturePress(recognizer, sample);
+        break;
+    case PEN_RELEASING:
+        break;
+    }
+}
+
+void twlcdcGestureAdvance(twlcdcGestureRecognizer *recognizer, u64 tick) {
+    if (penReleaseAdvance(&recognizer->state, recognizer->upTick, recognizer->config.upDebounce, tick)) {
+        gestureRelease(recognizer, recognizer->upTick);
+    }
+}
+
+bool twlcdcGestureNext(twlcdcGestureRecognizer *recognizer, twlcdcGesture *gesture) {
+    u8 slot;
+
+    if (!penQueueTake(&recognizer->head, &recognizer->count, TWLCDC_GESTURE_QUEUE_SIZE, &slot)) {
+        return false;
+    }
+    *gesture = recognizer->queue[slot];
+    return true;
+}
@@ -0,0 +1,95 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <string.h>
+#include <3ds.h>
+#include "twlcdc.h"
+
+// libctru hid-style touch input. The touch screen is sampled once per
+// twlcdcHidScanInput() call, right after hidScanInput(), so that button
+// and touch state always describe the same frame; every accessor then
+// reads the cached sample without any controller access.
+//
+// A failed read looks the same as pen-up, so while the pen is down one
+// failed read is bridged with the previous frame's sample; only a second
+// consecutive one releases the pen. Otherwise a single rejected or
+// glitched conversion would show up as a KEY_TOUCH release and re-press.
+
+#define HID_RELEASE_MISSES 2
+
+static struct {
+    twlcdcTouchPositionEx pos;
+    bool penDown;
+    bool wasPenDown;
+    u8 misses;
+} hidFrame;
+
+void twlcdcHidScanInput(void) {
+    twlcdcTouchPositionEx pos;
+
+    hidScanInput();
+
+    hidFrame.wasPenDown = hidFrame.penDown;
+    // With the pen up, the data buffer fails the validity check, so a
+    // single read also serves as the pen-down check.
+    if (twlcdcTouchReadEx(&pos)) {
+        hidFrame.pos = pos;
+        hidFrame.penDown = true;
+        hidFrame.misses = 0;
+    } else if (hidFrame.penDown && ++hidFrame.misses < HID_RELEASE_MISSES) {
+        // hold the previous sample
+    } else {
+        memset(&hidFrame.pos, 0, sizeof(hidFrame.pos));
+        hidFrame.penDown = false;
+        hidFrame.misses = 0;
+    }
+}
+
+u32 twlcdcHidKeysHeld(void) {
+    return (hidKeysHeld() & ~KEY_TOUCH) | (hidFrame.penDown ? KEY_TOUCH : 0);
+}
+
+u32 twlcdcHidKeysDown(void) {
+    return (hidKeysDown() & ~KEY_TOUCH) | (hidFrame.penDown && !hidFrame.wasPenDown ? KEY_TOUCH : 0);
+}
+
+u32 twlcdcHidKeysUp(void) {
+    return (hidKeysUp() & ~KEY_TOUCH) | (!hidFrame.penDown && hidFrame.wasPenDown ? KEY_TOUCH : 0);
+}
+
+void twlcdcHidTouchRead(touchPosition* pos) {
+    pos->px = hidFrame.pos.pos.px;
+    pos->py = hidFrame.pos.pos.py;
+}
+
+bool twlcdcHidTouchReadEx(twlcdcTouchPositionEx* pos) {
+    *pos = hidFrame.pos;
+    return hidFrame.penDown;
+}
+
+u32 twlcdcHidTouchPressure(void) {
+    return hidFrame.pos.pressure;
+}
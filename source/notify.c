@@ -0,0 +1,105 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <3ds.h>
+#include "twlcdc.h"
+#include "backoff.h"
+
+#define NOTIFY_STACK_SIZE 4096
+
+static struct {
+    Thread thread;
+    twlcdcBackoff backoff;
+    LightEvent penEvent;
+    LightEvent stopEvent;
+    bool started;
+} notify;
+
+static void notifyThreadMain(void *arg) {
+    u64 interval = notify.backoff.minInterval;
+
+    // stopEvent doubles as the sleep, so that stopping is not delayed by
+    // a long idle interval
+    while (LightEvent_WaitTimeout(&notify.stopEvent, interval)) {
+        bool penDown = twlcdcTouchPenDown();
+
+        if (penDown) {
+            LightEvent_Signal(&notify.penEvent);
+        } else {
+            LightEvent_Clear(&notify.penEvent);
+        }
+        interval = backoffNext(&notify.backoff, penDown);
+    }
+}
+
+bool twlcdcPenNotifyStart(u64 minIntervalNs, u64 maxIntervalNs) {
+    s32 priority;
+
+    if (notify.started) {
+        return false;
+    }
+
+    backoffInit(&notify.backoff, minIntervalNs, maxIntervalNs);
+    LightEvent_Init(&notify.penEvent, RESET_STICKY);
+    LightEvent_Init(&notify.stopEvent, RESET_STICKY);
+
+    svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+    if (priority > 0x18) {
+        priority--;
+    }
+
+    notify.thread = threadCreate(notifyThreadMain, NULL, NOTIFY_STACK_SIZE, priority, -2, false);
+    if (notify.thread == NULL) {
+        return false;
+    }
+    __atomic_store_n(&notify.started, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+void twlcdcPenNotifyStop(void) {
+    if (notify.started) {
+        LightEvent_Signal(&notify.stopEvent);
+        threadJoin(notify.thread, U64_MAX);
+        threadFree(notify.thread);
+        notify.thread = NULL;
+        // release any waiters; they must see the watcher stopped, not a
+        // pen-down, so clear the flag first
+        __atomic_store_n(&notify.started, false, __ATOMIC_SEQ_CST);
+        LightEvent_Signal(&notify.penEvent);
+    }
+}
+
+bool twlcdcWaitForPen(s64 timeout_ns) {
+    if (!__atomic_load_n(&notify.started, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    if (timeout_ns < 0) {
+        LightEvent_Wait(&notify.penEvent);
+    } else if (LightEvent_WaitTimeout(&notify.penEvent, timeout_ns)) {
+        return false;
+    }
+    return __atomic_load_n(&notify.started, __ATOMIC_ACQUIRE);
+}
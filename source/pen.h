@@ -0,0 +1,111 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_PEN_H__
+#define __LIBTWLCDC_PEN_H__
+
+#include <stdbool.h>
+#include "twlcdc.h"
+
+// Building blocks shared by the event tracker and the gesture recognizer:
+// their output queues, and the debouncing of pen releases.
+
+// Pen states; only the event tracker debounces presses.
+enum {
+    PEN_STATE_UP = 0,
+    PEN_STATE_PENDING_DOWN,
+    PEN_STATE_DOWN,
+    PEN_STATE_PENDING_UP
+};
+
+typedef enum {
+    PEN_HELD = 0,         // pen down; a pending release was contact bounce
+    PEN_RELEASING,        // pen up, not yet for the debounce time
+    PEN_RELEASED,         // the pen was released at the pending tick
+    PEN_RELEASED_PRESSED  // as above, and this sample starts a new press
+} penRelease;
+
+// Slot for a new entry of a fixed-size queue; the oldest entry is dropped
+// if the queue is full.
+static inline u8 penQueueAppend(u8 *head, u8 *count, u8 size) {
+    u8 slot;
+
+    if (*count >= size) {
+        *head = (*head + 1) % size;
+        (*count)--;
+    }
+    slot = (*head + *count) % size;
+    (*count)++;
+    return slot;
+}
+
+// Remove the oldest entry of a fixed-size queue; false if it is empty.
+static inline bool penQueueTake(u8 *head, u8 *count, u8 size, u8 *slot) {
+    if (*count == 0) {
+        return false;
+    }
+    *slot = *head;
+    *head = (*head + 1) % size;
+    (*count)--;
+    return true;
+}
+
+// Feed a sample to a pressed pen, in the DOWN or PENDING_UP state. A
+// release only counts once the pen stayed up for upDebounce ticks; upTick
+// holds the time it was first seen up, which is when it is reported.
+static inline penRelease penReleaseFeed(u8 *state, u64 *upTick, u64 upDebounce, const twlcdcTouchSample *sample) {
+    if (sample->penDown) {
+        if (*state == PEN_STATE_PENDING_UP && sample->tick - *upTick >= upDebounce) {
+            // Pen-up samples are not guaranteed to keep arriving, as the
+            // sampler only records the first one, so the release may only
+            // be confirmed by the next press.
+            *state = PEN_STATE_UP;
+            return PEN_RELEASED_PRESSED;
+        }
+        *state = PEN_STATE_DOWN;
+        return PEN_HELD;
+    }
+
+    if (*state == PEN_STATE_DOWN) {
+        *state = PEN_STATE_PENDING_UP;
+        *upTick = sample->tick;
+    }
+    if (sample->tick - *upTick >= upDebounce) {
+        *state = PEN_STATE_UP;
+        return PEN_RELEASED;
+    }
+    return PEN_RELEASING;
+}
+
+// Confirm a pending release once tick is upDebounce past it.
+static inline bool penReleaseAdvance(u8 *state, u64 upTick, u64 upDebounce, u64 tick) {
+    if (*state == PEN_STATE_PENDING_UP && tick - upTick >= upDebounce) {
+        *state = PEN_STATE_UP;
+        return true;
+    }
+    return false;
+}
+
+#endif /* __LIBTWLCDC_PEN_H__ */
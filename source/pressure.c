@@ -0,0 +1,199 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include "pressure.h"
+
+// There is no hardware divider on the ARM11, so divisions in this file are
+// done by multiplying with a reciprocal: a 64-entry table lookup refined
+// by two Newton-Raphson steps, accurate to about 28 bits.
+
+// 2^16 * 128 / (129 + 2*i): the reciprocal at the middle of each interval
+static const u16 recipLut[64] = {
+    0xFE04, 0xFA23, 0xF660, 0xF2BA, 0xEF2F, 0xEBBE, 0xE866, 0xE526,
+    0xE1FC, 0xDEE9, 0xDBEB, 0xD902, 0xD62C, 0xD368, 0xD0B7, 0xCE17,
+    0xCB87, 0xC908, 0xC698, 0xC437, 0xC1E5, 0xBFA0, 0xBD69, 0xBB3F,
+    0xB921, 0xB710, 0xB50A, 0xB30F, 0xB120, 0xAF3B, 0xAD60, 0xAB8F,
+    0xA9C8, 0xA80B, 0xA656, 0xA4AA, 0xA306, 0xA16B, 0x9FD8, 0x9E4D,
+    0x9CC9, 0x9B4C, 0x99D7, 0x9869, 0x9701, 0x95A0, 0x9446, 0x92F1,
+    0x91A3, 0x905A, 0x8F17, 0x8DDA, 0x8CA3, 0x8B70, 0x8A43, 0x891B,
+    0x87F8, 0x86D9, 0x85BF, 0x84AA, 0x8399, 0x828D, 0x8185, 0x8081,
+};
+
+u32 fixRecip(u32 d, int *shift) {
+    int n = __builtin_clz(d);
+    u32 m = d << n;
+    s64 y = (u32) recipLut[(m >> 25) & 0x3F] << 15;
+    s64 e;
+
+    e = (1LL << 62) - (s64) ((u64) m * y);
+    y += (y * (e >> 31)) >> 31;
+    e = (1LL << 62) - (s64) ((u64) m * y);
+    y += (y * (e >> 31)) >> 31;
+
+    *shift = n;
+    return y;
+}
+
+static twlcdcPressureModel pressureModel = { 0x00DE0000, 128 };
+// maxPressure * maxRadius, normalized to 32 significant bits
+static u32 pressureK = 0xDE000000;
+static int pressureKShift = 33;
+
+void pressureSetModel(const twlcdcPressureModel *model) {
+    u64 k = (u64) model->maxPressure * model->maxRadius;
+
+    pressureModel = *model;
+    if (k == 0) {
+        pressureK = 0;
+        pressureKShift = 0;
+    } else {
+        pressureKShift = __builtin_clzll(k);
+        pressureK = (k << pressureKShift) >> 32;
+    }
+}
+
+void pressureGetModel(twlcdcPressureModel *model) {
+    *model = pressureModel;
+}
+
+u32 pressureResistance(u16 rawx, u16 z1, u16 z2) {
+    u32 ratio, y;
+    u64 resistance;
+    int n;
+
+    if (z1 == 0 || z2 <= z1) {
+        return 0;
+    }
+
+    // z2 * 4096 / z1; z1 is a 12-bit value, so n >= 20
+    y = fixRecip(z1, &n);
+    ratio = ((u64) z2 * y) >> (50 - n);
+    // the reciprocal may be a hair low, which would floor exact quotients
+    // to one less
+    if ((u64) (ratio + 1) * z1 <= (u32) z2 * 4096) {
+        ratio++;
+    }
+    if (ratio <= 4096) {
+        return 0;
+    }
+
+    resistance = (u64) rawx * (ratio - 4096);
+    return resistance > 0xFFFFFFFF ? 0xFFFFFFFF : resistance;
+}
+
+// Quantile tracking: each estimate moves up by step * p when a sample lies
+// above it and down by step * (1 - p) otherwise, settling where a fraction
+// p of samples lies below it (Robbins-Monro). The step is relative to the
+// estimate, coarse while warming up so that a new device converges quickly.
+// Moves are rounded up, so that small estimates do not get stuck.
+
+#define TRACKER_LOW_QUANTILE  0x1999 // 0.1
+#define TRACKER_HIGH_QUANTILE 0xE666 // 0.9
+#define TRACKER_WARMUP 256
+
+static u32 trackerQuantile(u32 q, u32 resistance, u32 p, int stepShift) {
+    u64 step = (q >> stepShift) + 1;
+
+    if (resistance > q) {
+        u64 next = q + ((step * p + 0xFFFF) >> 16);
+        return next > resistance ? resistance : next;
+    } else if (resistance < q) {
+        u64 down = (step * (0x10000 - p) + 0xFFFF) >> 16;
+        return down >= q - resistance ? resistance : q - down;
+    }
+    return q;
+}
+
+void twlcdcPressureTrackerInit(twlcdcPressureTracker *tracker) {
+    tracker->low = 0;
+    tracker->high = 0;
+    tracker->count = 0;
+}
+
+void twlcdcPressureTrackerUpdate(twlcdcPressureTracker *tracker, u32 resistance) {
+    int stepShift;
+
+    if (resistance == 0) {
+        return;
+    }
+    if (tracker->count == 0) {
+        tracker->low = resistance;
+        tracker->high = resistance;
+    } else {
+        stepShift = tracker->count < TRACKER_WARMUP ? 4 : 7;
+        tracker->low = trackerQuantile(tracker->low, resistance, TRACKER_LOW_QUANTILE, stepShift);
+        tracker->high = trackerQuantile(tracker->high, resistance, TRACKER_HIGH_QUANTILE, stepShift);
+        if (tracker->high < tracker->low) {
+            tracker->high = tracker->low;
+        }
+    }
+    if (tracker->count < 0xFFFFFFFF) {
+        tracker->count++;
+    }
+}
+
+u32 twlcdcPressureTrackerNormalize(const twlcdcPressureTracker *tracker, u32 resistance) {
+    u32 y;
+    int n;
+
+    // lower resistance means a firmer press
+    if (resistance == 0 || tracker->high <= tracker->low) {
+        return 0;
+    }
+    if (resistance >= tracker->high) {
+        return 0;
+    }
+    if (resistance <= tracker->low) {
+        return 0x10000;
+    }
+
+    // ((high - resistance) << 16) / (high - low)
+    y = fixRecip(tracker->high - tracker->low, &n);
+    return ((u64) (tracker->high - resistance) * y) >> (46 - n);
+}
+
+u32 pressureFromResistance(u32 resistance) {
+    u64 result;
+    u32 y;
+    int n, shift;
+
+    if (resistance == 0 || pressureK == 0) {
+        return 0;
+    }
+
+    // (maxPressure * maxRadius << 16) / resistance
+    y = fixRecip(resistance, &n);
+    result = (u64) pressureK * y;
+    shift = 14 + pressureKShift - n;
+    if (shift < 0) {
+        return 0xFFFFFFFF;
+    }
+    if (shift >= 64) {
+        // a tiny model over a large resistance: less than one unit
+        return 0;
+    }
+    result >>= shift;
+    return result > 0xFFFFFFFF ? 0xFFFFFFFF : result;
+}
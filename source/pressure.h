@@ -0,0 +1,41 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_PRESSURE_H__
+#define __LIBTWLCDC_PRESSURE_H__
+
+#include "twlcdc.h"
+
+// Approximate 2^(62 - *shift) / d, for d != 0; the result is in (2^30, 2^31].
+u32 fixRecip(u32 d, int *shift);
+
+void pressureSetModel(const twlcdcPressureModel *model);
+void pressureGetModel(twlcdcPressureModel *model);
+// Touch resistance, rawx * (z2 / z1 - 1), in 1/4096 units; 0 if not measurable.
+u32 pressureResistance(u16 rawx, u16 z1, u16 z2);
+// Pressure value for a given touch resistance, in 16.16 fixed point.
+u32 pressureFromResistance(u32 resistance);
+
+#endif /* __LIBTWLCDC_PRESSURE_H__ */
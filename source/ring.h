@@ -0,0 +1,57 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_RING_H__
+#define __LIBTWLCDC_RING_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Touch sample as stored in the ring; the same fields as twlcdcTouchSample,
+// kept separate so that the ring does not depend on the 3DS headers.
+typedef struct ringSample {
+    uint64_t tick;
+    uint16_t rawx, rawy;
+    uint16_t px, py;
+    uint16_t z1, z2;
+    bool penDown;
+} ringSample;
+
+// Single-producer/single-consumer ring of touch samples.
+// The producer only writes head, the consumer only writes tail; neither
+// side ever blocks. Capacity must be a power of two.
+typedef struct twlcdcRing {
+    ringSample *data;
+    uint32_t mask;
+    uint32_t head;
+    uint32_t tail;
+} twlcdcRing;
+
+void ringInit(twlcdcRing *ring, ringSample *storage, uint32_t capacity);
+bool ringPush(twlcdcRing *ring, const ringSample *sample);
+size_t ringDrain(twlcdcRing *ring, ringSample *out, size_t count);
+
+#endif /* __LIBTWLCDC_RING_H__ */
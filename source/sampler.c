@@ -0,0 +1,189 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <3ds.h>
+#include "twlcdc.h"
+#include "codec_internal.h"
+#include "ring.h"
+
+#define SAMPLER_STACK_SIZE 4096
+#define SAMPLER_DRAIN_CHUNK 32
+
+// storageLock guards the ring storage against being freed, or set up
+// again, while twlcdcSamplerDrain() copies from it. The sampler thread
+// does not take it; the storage outlives the thread.
+static struct {
+    Thread thread;
+    LightLock storageLock;
+    twlcdcRing ring;
+    ringSample *storage;
+    u64 periodTicks;
+    u32 dropped;
+    volatile bool running;
+} sampler;
+
+static void samplerPush(const twlcdcTouchSample *sample) {
+    ringSample record = {
+        .tick = sample->tick,
+        .rawx = sample->pos.rawx, .rawy = sample->pos.rawy,
+        .px = sample->pos.px, .py = sample->pos.py,
+        .z1 = sample->pos.z1, .z2 = sample->pos.z2,
+        .penDown = sample->penDown
+    };
+
+    if (!ringPush(&sampler.ring, &record)) {
+        __atomic_add_fetch(&sampler.dropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void samplerThreadMain(void *arg) {
+    twlcdcTouchSample sample;
+    bool wasDown = false;
+    u64 deadline = svcGetSystemTick();
+    u64 now;
+
+    while (sampler.running) {
+        sample.penDown = twlcdcTouchPoll(&sample.pos, TWLCDC_POLL_FAST);
+        sample.tick = cdcGetTick();
+
+        // Pen-up is only recorded on the falling edge, so that an idle
+        // sampler does not fill the ring with redundant records.
+        if (sample.penDown || wasDown) {
+            samplerPush(&sample);
+        }
+        wasDown = sample.penDown;
+
+        deadline += sampler.periodTicks;
+        now = svcGetSystemTick();
+        if (deadline > now) {
+            svcSleepThread((deadline - now) * 1000000000ULL / SYSCLOCK_ARM11);
+        } else {
+            // We fell behind; don't try to catch up with a burst of reads.
+            deadline = now;
+        }
+    }
+}
+
+bool twlcdcSamplerStart(u32 rate_hz, u32 capacity) {
+    ringSample *storage;
+    s32 priority;
+    u32 size;
+
+    if (sampler.running || rate_hz == 0 || capacity == 0) {
+        return false;
+    }
+
+    // round the capacity up to a power of two
+    for (size = 1; size < capacity; size <<= 1) {
+        if (size & 0x80000000) {
+            return false;
+        }
+    }
+
+    storage = malloc(size * sizeof(ringSample));
+    if (storage == NULL) {
+        return false;
+    }
+    LightLock_Lock(&sampler.storageLock);
+    sampler.storage = storage;
+    ringInit(&sampler.ring, storage, size);
+    LightLock_Unlock(&sampler.storageLock);
+    sampler.periodTicks = SYSCLOCK_ARM11 / rate_hz;
+    sampler.dropped = 0;
+    sampler.running = true;
+
+    // run just above the caller, so that sampling is not starved by the main loop
+    svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+    if (priority > 0x18) {
+        priority--;
+    }
+
+    sampler.thread = threadCreate(samplerThreadMain, NULL, SAMPLER_STACK_SIZE, priority, -2, false);
+    if (sampler.thread == NULL) {
+        sampler.running = false;
+        LightLock_Lock(&sampler.storageLock);
+        sampler.storage = NULL;
+        LightLock_Unlock(&sampler.storageLock);
+        free(storage);
+        return false;
+    }
+    return true;
+}
+
+void twlcdcSamplerStop(void) {
+    if (sampler.thread != NULL) {
+        sampler.running = false;
+        threadJoin(sampler.thread, U64_MAX);
+        threadFree(sampler.thread);
+        sampler.thread = NULL;
+    }
+    LightLock_Lock(&sampler.storageLock);
+    free(sampler.storage);
+    sampler.storage = NULL;
+    LightLock_Unlock(&sampler.storageLock);
+}
+
+size_t twlcdcSamplerDrain(twlcdcTouchSample *buf, size_t count) {
+    ringSample chunk[SAMPLER_DRAIN_CHUNK];
+    size_t total = 0;
+
+    LightLock_Lock(&sampler.storageLock);
+    if (sampler.storage == NULL) {
+        LightLock_Unlock(&sampler.storageLock);
+        return 0;
+    }
+    while (total < count) {
+        size_t want = count - total;
+        size_t got, i;
+
+        if (want > SAMPLER_DRAIN_CHUNK) {
+            want = SAMPLER_DRAIN_CHUNK;
+        }
+        got = ringDrain(&sampler.ring, chunk, want);
+        for (i = 0; i < got; i++) {
+            twlcdcTouchSample *out = &buf[total + i];
+            out->tick = chunk[i].tick;
+            out->pos.rawx = chunk[i].rawx;
+            out->pos.rawy = chunk[i].rawy;
+            out->pos.px = chunk[i].px;
+            out->pos.py = chunk[i].py;
+            out->pos.z1 = chunk[i].z1;
+            out->pos.z2 = chunk[i].z2;
+            out->penDown = chunk[i].penDown;
+        }
+        total += got;
+        if (got < want) {
+            break;
+        }
+    }
+    LightLock_Unlock(&sampler.storageLock);
+    return total;
+}
+
+u32 twlcdcSamplerDropped(void) {
+    return __atomic_exchange_n(&sampler.dropped, 0, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,160 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "settings.h"
+
+// Pure serialization; applying the settings is done in twlcdc.c.
+
+static const u32 crcNibbleTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+u32 settingsCrc32(const u8 *data, size_t size) {
+    u32 crc = 0xFFFFFFFF;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crcNibbleTable[crc & 0xF];
+        crc = (crc >> 4) ^ crcNibbleTable[crc & 0xF];
+    }
+    return ~crc;
+}
+
+static u8 *settingsPutLE(u8 *out, u64 value, int size) {
+    int i;
+    for (i = 0; i < size; i++) {
+        out[i] = value >> (i * 8);
+    }
+    return out + size;
+}
+
+static u64 settingsGetLE(const u8 **in, int size) {
+    u64 value = 0;
+    int i;
+    for (i = size - 1; i >= 0; i--) {
+        value = (value << 8) | (*in)[i];
+    }
+    *in += size;
+    return value;
+}
+
+void settingsEncode(const settingsState *state, u8 *out) {
+    const twlcdcTouchCalibration *c = &state->calibration;
+    const twlcdcTscConfig *t = &state->tscConfig;
+    u8 *p = out + SETTINGS_HEADER_SIZE;
+
+    p = settingsPutLE(p, (u16) c->calX1, 2);
+    p = settingsPutLE(p, (u16) c->calY1, 2);
+    p = settingsPutLE(p, (u16) c->calX1px, 2);
+    p = settingsPutLE(p, (u16) c->calY1px, 2);
+    p = settingsPutLE(p, (u16) c->calX2, 2);
+    p = settingsPutLE(p, (u16) c->calY2, 2);
+    p = settingsPutLE(p, (u16) c->calX2px, 2);
+    p = settingsPutLE(p, (u16) c->calY2px, 2);
+    p = settingsPutLE(p, (u32) state->m[0][0], 4);
+    p = settingsPutLE(p, (u32) state->m[0][1], 4);
+    p = settingsPutLE(p, (u32) state->m[1][0], 4);
+    p = settingsPutLE(p, (u32) state->m[1][1], 4);
+    p = settingsPutLE(p, (u64) state->offset[0], 8);
+    p = settingsPutLE(p, (u64) state->offset[1], 8);
+    p = settingsPutLE(p, state->filter, 1);
+    p = settingsPutLE(p, 0, 1);
+    p = settingsPutLE(p, state->maxSpread, 2);
+    p = settingsPutLE(p, t->clockDivider, 1);
+    p = settingsPutLE(p, t->conversionMode, 1);
+    p = settingsPutLE(p, t->prechargeTime, 1);
+    p = settingsPutLE(p, t->senseTime, 1);
+    p = settingsPutLE(p, t->stabilizationTime, 1);
+    p = settingsPutLE(p, t->bufferTrigger, 1);
+    p = settingsPutLE(p, t->scanTimer, 1);
+    p = settingsPutLE(p, t->scanTimerClock, 1);
+    p = settingsPutLE(p, state->pressureModel.maxPressure, 4);
+    p = settingsPutLE(p, state->pressureModel.maxRadius, 2);
+    p = settingsPutLE(p, 0, 2);
+    p = settingsPutLE(p, state->flags, 4);
+    p = settingsPutLE(p, state->pressureTracker.low, 4);
+    p = settingsPutLE(p, state->pressureTracker.high, 4);
+    p = settingsPutLE(p, state->pressureTracker.count, 4);
+
+    memcpy(out, SETTINGS_MAGIC, 4);
+    settingsPutLE(out + 4, SETTINGS_VERSION, 2);
+    settingsPutLE(out + 6, TWLCDC_SETTINGS_SIZE, 2);
+    settingsPutLE(out + 8, settingsCrc32(out + SETTINGS_HEADER_SIZE, TWLCDC_SETTINGS_SIZE - SETTINGS_HEADER_SIZE), 4);
+}
+
+bool settingsDecode(settingsState *state, const u8 *in, size_t size) {
+    twlcdcTouchCalibration *c = &state->calibration;
+    twlcdcTscConfig *t = &state->tscConfig;
+    const u8 *p = in + 4;
+
+    if (size < TWLCDC_SETTINGS_SIZE || memcmp(in, SETTINGS_MAGIC, 4) != 0
+        || settingsGetLE(&p, 2) != SETTINGS_VERSION
+        || settingsGetLE(&p, 2) != TWLCDC_SETTINGS_SIZE
+        || settingsGetLE(&p, 4) != settingsCrc32(in + SETTINGS_HEADER_SIZE, TWLCDC_SETTINGS_SIZE - SETTINGS_HEADER_SIZE)) {
+        return false;
+    }
+
+    c->calX1 = settingsGetLE(&p, 2);
+    c->calY1 = settingsGetLE(&p, 2);
+    c->calX1px = settingsGetLE(&p, 2);
+    c->calY1px = settingsGetLE(&p, 2);
+    c->calX2 = settingsGetLE(&p, 2);
+    c->calY2 = settingsGetLE(&p, 2);
+    c->calX2px = settingsGetLE(&p, 2);
+    c->calY2px = settingsGetLE(&p, 2);
+    state->m[0][0] = settingsGetLE(&p, 4);
+    state->m[0][1] = settingsGetLE(&p, 4);
+    state->m[1][0] = settingsGetLE(&p, 4);
+    state->m[1][1] = settingsGetLE(&p, 4);
+    state->offset[0] = settingsGetLE(&p, 8);
+    state->offset[1] = settingsGetLE(&p, 8);
+    state->filter = settingsGetLE(&p, 1);
+    settingsGetLE(&p, 1);
+    state->maxSpread = settingsGetLE(&p, 2);
+    t->clockDivider = settingsGetLE(&p, 1);
+    t->conversionMode = settingsGetLE(&p, 1);
+    t->prechargeTime = settingsGetLE(&p, 1);
+    t->senseTime = settingsGetLE(&p, 1);
+    t->stabilizationTime = settingsGetLE(&p, 1);
+    t->bufferTrigger = settingsGetLE(&p, 1);
+    t->scanTimer = settingsGetLE(&p, 1);
+    t->scanTimerClock = settingsGetLE(&p, 1);
+    state->pressureModel.maxPressure = settingsGetLE(&p, 4);
+    state->pressureModel.maxRadius = settingsGetLE(&p, 2);
+    settingsGetLE(&p, 2);
+    state->flags = settingsGetLE(&p, 4);
+    state->pressureTracker.low = settingsGetLE(&p, 4);
+    state->pressureTracker.high = settingsGetLE(&p, 4);
+    state->pressureTracker.count = settingsGetLE(&p, 4);
+
+    return state->filter <= TWLCDC_FILTER_REJECT_SPREAD;
+}
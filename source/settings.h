@@ -0,0 +1,61 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_SETTINGS_H__
+#define __LIBTWLCDC_SETTINGS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "twlcdc.h"
+
+// Blob layout, all values little endian:
+// header: "TWLS", u16 version, u16 total size, u32 CRC-32 of the payload
+// payload: calibration (8 x s16), transform (4 x s32, 2 x s64),
+//          u8 filter, u8 reserved, u16 max spread, TSC config (8 x u8),
+//          pressure model (u32, u16, u16 reserved),
+//          u32 flags, pressure tracker (3 x u32)
+#define SETTINGS_MAGIC        "TWLS"
+#define SETTINGS_VERSION      1
+#define SETTINGS_HEADER_SIZE  12
+
+#define SETTINGS_FLAG_PRESSURE_TRACKING BIT(0)
+
+typedef struct settingsState {
+    twlcdcTouchCalibration calibration;
+    s32 m[2][2];
+    s64 offset[2];
+    twlcdcFilter filter;
+    u16 maxSpread;
+    twlcdcTscConfig tscConfig;
+    twlcdcPressureModel pressureModel;
+    u32 flags;
+    twlcdcPressureTracker pressureTracker;
+} settingsState;
+
+u32 settingsCrc32(const u8 *data, size_t size);
+void settingsEncode(const settingsState *state, u8 *out);
+bool settingsDecode(settingsState *state, const u8 *in, size_t size);
+
+#endif /* __LIBTWLCDC_SETTINGS_H__ */
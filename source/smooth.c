@@ -0,0 +1,150 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "pressure.h"
+
+// Adaptive low-pass filter after Casiez et al., "1 Euro Filter", with an
+// optional alpha-beta tracker on its output for latency compensation.
+// Positions are 16.16 fixed point pixels, speeds 16.16 pixels per second.
+// The sample interval is turned into a rate and a duration once per sample,
+// so the filter itself only multiplies; the ARM11 has no divide instruction.
+
+// 2 * pi * 65536 / (256 * 1000000), in 4.28 fixed point
+#define SMOOTH_OMEGA_SCALE 431777
+// gaps longer than this start a new stroke
+#define SMOOTH_RESET_US 100000
+#define SMOOTH_RESET_TICKS ((u64) SMOOTH_RESET_US * SYSCLOCK_ARM11 / 1000000)
+// microseconds per tick, in 0.40 fixed point
+#define SMOOTH_US_PER_TICK ((1000000ULL << 40) / SYSCLOCK_ARM11)
+// seconds per microsecond, in 0.32 fixed point
+#define SMOOTH_SECONDS_PER_US 4295
+// cutoff frequency of the speed estimate, in 24.8 fixed point Hz
+#define SMOOTH_DERIV_CUTOFF (1 << 8)
+// Speeds are kept in 64 bits, as a fast flick easily exceeds 32767 px/s;
+// they are bounded so that the cutoff computation below cannot overflow.
+#define SMOOTH_MAX_SPEED (1LL << 39)
+// beyond this cutoff (64 kHz), alpha is 1 for any sample interval
+#define SMOOTH_MAX_CUTOFF (1 << 24)
+
+typedef struct {
+    u32 dtUs;    // sample interval, in microseconds
+    u32 seconds; // the same, in 0.32 fixed point seconds
+    u64 hz;      // its reciprocal, in 16.16 fixed point Hz
+    u32 alphaD;  // smoothing factor of the speed estimate
+} smoothStep;
+
+static inline s32 smoothSaturate(s64 value) {
+    return value > INT32_MAX ? INT32_MAX : (value < INT32_MIN ? INT32_MIN : value);
+}
+
+// value * hz / 65536, for |value| < 2^43 and hz up to 1 MHz
+static inline s64 smoothPerSecond(s64 value, u64 hz) {
+    return value * (s64) (hz >> 16) + ((value * (s64) (hz & 0xFFFF)) >> 16);
+}
+
+// value * seconds / 2^32, for |value| < 2^39 and seconds below 2^40
+static inline s64 smoothOver(s64 value, u64 seconds) {
+    return ((value >> 16) * (s64) seconds + (((value & 0xFFFF) * (s64) seconds) >> 16)) >> 16;
+}
+
+// alpha = w / (w + 1), where w = 2 * pi * cutoff * dt; in 16.16 fixed point
+static u32 smoothAlpha(u32 cutoff, u32 dtUs) {
+    u64 w = ((u64) cutoff * dtUs * SMOOTH_OMEGA_SCALE) >> 28;
+    u32 recip;
+    int shift;
+
+    if (w > 0xFFFFFFFF - 65536) {
+        return 65535;
+    }
+    recip = fixRecip(w + 65536, &shift);
+    return (w * recip) >> (46 - shift);
+}
+
+void twlcdcSmootherInit(twlcdcSmoother *smoother, const twlcdcSmootherConfig *config) {
+    memset(smoother, 0, sizeof(twlcdcSmoother));
+    smoother->config = *config;
+}
+
+void twlcdcSmootherReset(twlcdcSmoother *smoother) {
+    smoother->primed = false;
+}
+
+static s32 smoothAxis(twlcdcSmoother *smoother, int axis, s32 value, const smoothStep *step) {
+    const twlcdcSmootherConfig *config = &smoother->config;
+    s64 speed = smoothPerSecond((s64) value - smoother->x[axis], step->hz);
+    s64 predicted, residual;
+    u64 cutoff;
+    u32 alpha;
+
+    if (speed > SMOOTH_MAX_SPEED) speed = SMOOTH_MAX_SPEED; else if (speed < -SMOOTH_MAX_SPEED) speed = -SMOOTH_MAX_SPEED;
+    smoother->dx[axis] += ((speed - smoother->dx[axis]) * step->alphaD) >> 16;
+    cutoff = config->minCutoff + ((((u64) (smoother->dx[axis] < 0 ? -smoother->dx[axis] : smoother->dx[axis]) >> 8) * config->beta) >> 16);
+    alpha = smoothAlpha(cutoff > SMOOTH_MAX_CUTOFF ? SMOOTH_MAX_CUTOFF : cutoff, step->dtUs);
+    smoother->x[axis] += (((s64) value - smoother->x[axis]) * alpha) >> 16;
+
+    if (config->predictUs == 0) {
+        return smoother->x[axis];
+    }
+
+    // Track the smoothed position, then extrapolate along the tracked velocity.
+    predicted = smoother->ab[axis] + smoothOver(smoother->v[axis], step->seconds);
+    residual = smoother->x[axis] - predicted;
+    smoother->ab[axis] = smoothSaturate(predicted + ((residual * config->alphaGain) >> 16));
+    smoother->v[axis] += smoothPerSecond((residual * config->betaGain) >> 16, step->hz);
+    if (smoother->v[axis] > SMOOTH_MAX_SPEED) smoother->v[axis] = SMOOTH_MAX_SPEED; else if (smoother->v[axis] < -SMOOTH_MAX_SPEED) smoother->v[axis] = -SMOOTH_MAX_SPEED;
+    return smoothSaturate(smoother->ab[axis] + smoothOver(smoother->v[axis], (u64) config->predictUs * SMOOTH_SECONDS_PER_US));
+}
+
+void twlcdcSmootherApply(twlcdcSmoother *smoother, s32 *x, s32 *y, u64 tick) {
+    u64 ticks = tick - smoother->lastTick;
+    smoothStep step;
+    u32 recip;
+    int shift;
+
+    smoother->lastTick = tick;
+    if (!smoother->primed || ticks > SMOOTH_RESET_TICKS) {
+        smoother->primed = true;
+        smoother->x[0] = smoother->ab[0] = *x;
+        smoother->x[1] = smoother->ab[1] = *y;
+        smoother->dx[0] = smoother->v[0] = 0;
+        smoother->dx[1] = smoother->v[1] = 0;
+        return;
+    }
+
+    step.dtUs = (ticks * SMOOTH_US_PER_TICK) >> 40;
+    if (step.dtUs == 0) {
+        step.dtUs = 1;
+    }
+    step.seconds = step.dtUs * SMOOTH_SECONDS_PER_US;
+    recip = fixRecip(step.dtUs, &shift);
+    step.hz = ((u64) 1000000 * recip) >> (46 - shift);
+    step.alphaD = smoothAlpha(SMOOTH_DERIV_CUTOFF, step.dtUs);
+
+    *x = smoothAxis(smoother, 0, *x, &step);
+    *y = smoothAxis(smoother, 1, *y, &step);
+}
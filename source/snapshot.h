@@ -0,0 +1,78 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_SNAPSHOT_H__
+#define __LIBTWLCDC_SNAPSHOT_H__
+
+#include <stdbool.h>
+#include <3ds.h>
+
+// Double-buffered snapshot: the writer fills the buffer readers are not
+// using, then flips the index to publish it. Each buffer carries its own
+// sequence number, odd while it is being written, so that a reader which
+// was overtaken by two writes notices and retries.
+//
+// Unlike a plain sequence lock, readers never wait for a writer: with the
+// strict thread priorities of Horizon, a reader spinning until a preempted
+// lower-priority writer finishes could spin forever. A buffer can only be
+// under write once the index has moved to the other one, so re-reading the
+// index always makes progress. Writers must be serialized externally.
+
+typedef struct snapshotState {
+    u32 index;
+    u32 sequence[2];
+} snapshotState;
+
+// Pick the buffer to copy from; pass the results to snapshotReadRetry().
+static inline int snapshotReadBegin(const snapshotState *state, u32 *sequence) {
+    for (;;) {
+        int index = __atomic_load_n(&state->index, __ATOMIC_ACQUIRE) & 1;
+        u32 value = __atomic_load_n(&state->sequence[index], __ATOMIC_ACQUIRE);
+        if (!(value & 1)) {
+            *sequence = value;
+            return index;
+        }
+    }
+}
+
+static inline bool snapshotReadRetry(const snapshotState *state, int index, u32 sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&state->sequence[index], __ATOMIC_RELAXED) != sequence;
+}
+
+// Returns the buffer to fill.
+static inline int snapshotWriteBegin(snapshotState *state) {
+    int index = (state->index & 1) ^ 1;
+    __atomic_store_n(&state->sequence[index], state->sequence[index] + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return index;
+}
+
+static inline void snapshotWriteEnd(snapshotState *state, int index) {
+    __atomic_store_n(&state->sequence[index], state->sequence[index] + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&state->index, index, __ATOMIC_RELEASE);
+}
+
+#endif /* __LIBTWLCDC_SNAPSHOT_H__ */
@@ -0,0 +1,92 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <string.h>
+#include <3ds.h>
+#include "twlcdc.h"
+#include "codec_internal.h"
+#include "stats.h"
+
+#ifdef TWLCDC_STATS
+
+static twlcdcStats stats;
+
+void statsCountIpc(u8 bank) {
+    if (bank == CDC_TOUCHCNT) {
+        stats.ipcTouchCnt++;
+    } else if (bank == CDC_TOUCHDATA) {
+        stats.ipcTouchData++;
+    } else {
+        stats.ipcOther++;
+    }
+}
+
+void statsCountInvalid(void) {
+    stats.invalidSamples++;
+}
+
+void statsRecordLatency(twlcdcStatOp op, u64 ticks) {
+    twlcdcLatencyStats *latency = &stats.latency[op];
+    int bucket;
+
+    if (latency->count == 0 || ticks < latency->minTicks) {
+        latency->minTicks = ticks;
+    }
+    if (ticks > latency->maxTicks) {
+        latency->maxTicks = ticks;
+    }
+    latency->totalTicks += ticks;
+    latency->count++;
+
+    bucket = ticks < 2 ? 0 : 63 - __builtin_clzll(ticks) - TWLCDC_STATS_HISTOGRAM_SHIFT;
+    if (bucket < 0) {
+        bucket = 0;
+    } else if (bucket >= TWLCDC_STATS_HISTOGRAM_SIZE) {
+        bucket = TWLCDC_STATS_HISTOGRAM_SIZE - 1;
+    }
+    latency->histogram[bucket]++;
+}
+
+bool twlcdcGetStats(twlcdcStats *out) {
+    *out = stats;
+    return true;
+}
+
+void twlcdcResetStats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+#else
+
+bool twlcdcGetStats(twlcdcStats *out) {
+    memset(out, 0, sizeof(twlcdcStats));
+    return false;
+}
+
+void twlcdcResetStats(void) {
+}
+
+#endif
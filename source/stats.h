@@ -0,0 +1,53 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_STATS_H__
+#define __LIBTWLCDC_STATS_H__
+
+#include <3ds.h>
+#include "twlcdc.h"
+
+// Statistics collection is compiled in only when building with TWLCDC_STATS.
+#ifdef TWLCDC_STATS
+
+void statsCountIpc(u8 bank);
+void statsCountInvalid(void);
+void statsRecordLatency(twlcdcStatOp op, u64 ticks);
+
+#define STATS_IPC(bank)          statsCountIpc(bank)
+#define STATS_INVALID()          statsCountInvalid()
+#define STATS_BEGIN(start)       u64 start = svcGetSystemTick()
+#define STATS_END(op, start)     statsRecordLatency(op, svcGetSystemTick() - (start))
+
+#else
+
+#define STATS_IPC(bank)          ((void) 0)
+#define STATS_INVALID()          ((void) 0)
+#define STATS_BEGIN(start)
+#define STATS_END(op, start)     ((void) 0)
+
+#endif
+
+#endif /* __LIBTWLCDC_STATS_H__ */
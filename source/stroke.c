@@ -0,0 +1,197 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <string.h>
+#include "twlcdc.h"
+
+// Stroke resampling: input points are optionally smoothed with a centripetal
+// Catmull-Rom spline, flattened into short line segments, and those are
+// walked to emit points at fixed arc-length intervals. All arithmetic is
+// done on 16.16 fixed point coordinates.
+
+// line segments per spline segment
+#define STROKE_SUBDIVISIONS 8
+
+// Bit-by-bit square root, starting from the highest set bit; the digit
+// selection is branchless, as its outcome is unpredictable.
+static u32 strokeSqrt(u64 value) {
+    u64 result = 0;
+    u64 bit;
+
+    if (value == 0) {
+        return 0;
+    }
+    bit = 1ULL << ((63 - __builtin_clzll(value)) & ~1);
+    while (bit != 0) {
+        u64 trial = result + bit;
+        u64 mask = -(u64) (value >= trial);
+        value -= trial & mask;
+        result = (result >> 1) + (bit & mask);
+        bit >>= 2;
+    }
+    return result;
+}
+
+static void strokeEmit(twlcdcStroke *stroke, s32 x, s32 y, u32 pressure) {
+    twlcdcStrokePoint *point;
+
+    if (stroke->count >= stroke->capacity) {
+        stroke->overflow = true;
+        return;
+    }
+    point = &stroke->arena[stroke->count++];
+    point->x = x;
+    point->y = y;
+    point->pressure = pressure;
+}
+
+// Walk from the cursor to a point, emitting resampled points on the way.
+static void strokeWalk(twlcdcStroke *stroke, s32 x, s32 y, u32 pressure) {
+    twlcdcStrokePoint *from = &stroke->cursor;
+    s64 dx = x - from->x;
+    s64 dy = y - from->y;
+    s64 dp = (s64) pressure - from->pressure;
+    s64 length = strokeSqrt(dx * dx + dy * dy);
+    s64 distance = stroke->spacing - stroke->traveled;
+
+    while (distance <= length) {
+        strokeEmit(stroke,
+            from->x + dx * distance / length,
+            from->y + dy * distance / length,
+            from->pressure + dp * distance / length);
+        distance += stroke->spacing;
+    }
+
+    stroke->traveled = length - (distance - stroke->spacing);
+    from->x = x;
+    from->y = y;
+    from->pressure = pressure;
+}
+
+// Centripetal knot interval between two points: the square root of their
+// distance, with 8 extra fractional bits.
+static s64 strokeKnot(const twlcdcStrokePoint *a, const twlcdcStrokePoint *b) {
+    s64 dx = b->x - a->x;
+    s64 dy = b->y - a->y;
+
+    return strokeSqrt((u64) strokeSqrt(dx * dx + dy * dy) << 16);
+}
+
+// Flatten the spline segment between ctrl[1] and ctrl[2].
+//
+// The knots are spaced by the square root of the distance between control
+// points (alpha = 0.5), which, unlike uniform knots, can neither loop nor
+// backtrack on unevenly spaced input. The segment is evaluated in Hermite
+// form, with tangents scaled to the segment's own knot interval.
+static void strokeSpline(twlcdcStroke *stroke) {
+    const twlcdcStrokePoint *p = stroke->ctrl;
+    s64 t01 = strokeKnot(&p[0], &p[1]);
+    s64 t12 = strokeKnot(&p[1], &p[2]);
+    s64 t23 = strokeKnot(&p[2], &p[3]);
+    s64 m1[2], m2[2];
+    s64 k;
+    int i;
+
+    if (t12 == 0) {
+        // repeated point; nothing to draw
+        return;
+    }
+
+    for (i = 0; i < 2; i++) {
+        s64 p0 = i ? p[0].y : p[0].x;
+        s64 p1 = i ? p[1].y : p[1].x;
+        s64 p2 = i ? p[2].y : p[2].x;
+        s64 p3 = i ? p[3].y : p[3].x;
+        // a repeated end point (t01 or t23 == 0) stands for the mirror
+        // image of the other one, which makes the tangent the chord
+        m1[i] = t01 == 0 ? p2 - p1 : (p1 - p0) * t12 / t01 - (p2 - p0) * t12 / (t01 + t12) + (p2 - p1);
+        m2[i] = t23 == 0 ? p2 - p1 : (p2 - p1) - (p3 - p1) * t12 / (t12 + t23) + (p3 - p2) * t12 / t23;
+    }
+
+    // t = k / 8; the Hermite basis functions are scaled by 512
+    for (k = 1; k <= STROKE_SUBDIVISIONS; k++) {
+        s64 h00 = 2 * k * k * k - 24 * k * k + 512;
+        s64 h10 = k * k * k - 16 * k * k + 64 * k;
+        s64 h01 = 512 - h00;
+        s64 h11 = k * k * k - 8 * k * k;
+        s64 x = (h00 * p[1].x + h10 * m1[0] + h01 * p[2].x + h11 * m2[0]) / 512;
+        s64 y = (h00 * p[1].y + h10 * m1[1] + h01 * p[2].y + h11 * m2[1]) / 512;
+        // pressure is interpolated linearly, to avoid overshoot
+        u32 pressure = p[1].pressure + ((s64) p[2].pressure - p[1].pressure) * k / STROKE_SUBDIVISIONS;
+        strokeWalk(stroke, x, y, pressure);
+    }
+}
+
+void twlcdcStrokeBegin(twlcdcStroke *stroke, twlcdcStrokePoint *arena, size_t capacity, s32 spacing, twlcdcStrokeSmoothing smoothing) {
+    memset(stroke, 0, sizeof(twlcdcStroke));
+    stroke->arena = arena;
+    stroke->capacity = capacity;
+    stroke->spacing = spacing > 0 ? spacing : 1;
+    stroke->smoothing = smoothing;
+}
+
+bool twlcdcStrokeAdd(twlcdcStroke *stroke, const twlcdcStrokePoint *point) {
+    if (stroke->ctrlCount == 0) {
+        // the first point is always emitted as-is
+        stroke->cursor = *point;
+        stroke->ctrl[0] = *point;
+        stroke->ctrl[1] = *point;
+        stroke->ctrlCount = 2;
+        strokeEmit(stroke, point->x, point->y, point->pressure);
+    } else if (stroke->smoothing == TWLCDC_STROKE_LINEAR) {
+        strokeWalk(stroke, point->x, point->y, point->pressure);
+    } else {
+        stroke->ctrl[stroke->ctrlCount++] = *point;
+        if (stroke->ctrlCount == 4) {
+            strokeSpline(stroke);
+            memmove(&stroke->ctrl[0], &stroke->ctrl[1], 3 * sizeof(twlcdcStrokePoint));
+            stroke->ctrlCount = 3;
+        }
+    }
+
+    return !stroke->overflow;
+}
+
+bool twlcdcStrokeEnd(twlcdcStroke *stroke) {
+    if (stroke->smoothing != TWLCDC_STROKE_LINEAR && stroke->ctrlCount == 3) {
+        // the last point has no successor; extend the curve with a copy
+        stroke->ctrl[3] = stroke->ctrl[2];
+        strokeSpline(stroke);
+    }
+    if (stroke->traveled > 0) {
+        // end the stroke exactly where the pen was lifted
+        strokeEmit(stroke, stroke->cursor.x, stroke->cursor.y, stroke->cursor.pressure);
+        stroke->traveled = 0;
+    }
+    stroke->ctrlCount = 0;
+
+    return !stroke->overflow;
+}
+
+void twlcdcStrokeClear(twlcdcStroke *stroke) {
+    stroke->count = 0;
+    stroke->overflow = false;
+}
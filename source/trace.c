@@ -0,0 +1,177 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <3ds.h>
+#include "twlcdc.h"
+#include "codec_internal.h"
+#include "trace.h"
+
+// Records are collected in memory and written out in large blocks, so
+// that capturing does not add file I/O to every read.
+#define TRACE_BUFFER_RECORDS 128
+
+bool traceCapturing = false;
+static bool traceFailed;
+static FILE *traceFile;
+static u8 traceBuffer[TRACE_BUFFER_RECORDS * TRACE_RECORD_SIZE];
+static u32 traceBufferCount;
+
+static void tracePutLE(u8 *out, u64 value, int size) {
+    int i;
+    for (i = 0; i < size; i++) {
+        out[i] = value >> (i * 8);
+    }
+}
+
+static u64 traceGetLE(const u8 *in, int size) {
+    u64 value = 0;
+    int i;
+    for (i = size - 1; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+static void traceFlush(void) {
+    if (traceBufferCount > 0) {
+        if (fwrite(traceBuffer, TRACE_RECORD_SIZE, traceBufferCount, traceFile) != traceBufferCount) {
+            // The file now ends in a partial block; stop recording rather
+            // than leave a gap in the middle of the capture.
+            traceFailed = true;
+            traceCapturing = false;
+        }
+        traceBufferCount = 0;
+    }
+}
+
+void traceCaptureRecord(const u8 *raw) {
+    u8 *record = traceBuffer + traceBufferCount * TRACE_RECORD_SIZE;
+
+    tracePutLE(record, cdcGetTick(), 8);
+    memcpy(record + 8, raw, TRACE_RAW_SIZE);
+    if (++traceBufferCount >= TRACE_BUFFER_RECORDS) {
+        traceFlush();
+    }
+}
+
+bool traceCaptureStart(FILE *file) {
+    u8 header[TRACE_HEADER_SIZE];
+
+    if (traceCapturing || file == NULL) {
+        return false;
+    }
+
+    memcpy(header, TRACE_MAGIC, 4);
+    tracePutLE(header + 4, TRACE_VERSION, 2);
+    tracePutLE(header + 6, TRACE_RECORD_SIZE, 2);
+    tracePutLE(header + 8, SYSCLOCK_ARM11, 4);
+    tracePutLE(header + 12, 0, 4);
+    if (fwrite(header, sizeof(header), 1, file) != 1) {
+        return false;
+    }
+
+    traceFile = file;
+    traceBufferCount = 0;
+    traceFailed = false;
+    traceCapturing = true;
+    return true;
+}
+
+bool traceCaptureStop(void) {
+    bool result;
+
+    if (traceFile == NULL) {
+        return true;
+    }
+    if (traceCapturing) {
+        traceFlush();
+        traceCapturing = false;
+    }
+    if (fflush(traceFile) != 0) {
+        traceFailed = true;
+    }
+    result = !traceFailed;
+    traceFile = NULL;
+    return result;
+}
+
+bool twlcdcReplayInit(twlcdcReplay *replay, const void *data, size_t size) {
+    const u8 *header = data;
+
+    if (size < TRACE_HEADER_SIZE || memcmp(header, TRACE_MAGIC, 4) != 0
+        || traceGetLE(header + 4, 2) != TRACE_VERSION
+        || traceGetLE(header + 6, 2) != TRACE_RECORD_SIZE) {
+        return false;
+    }
+
+    replay->data = header + TRACE_HEADER_SIZE;
+    replay->count = (size - TRACE_HEADER_SIZE) / TRACE_RECORD_SIZE;
+    replay->position = 0;
+    replay->tick = 0;
+    return true;
+}
+
+static Result traceReplayRead(void* userdata, u8 bank, u8 reg, void* data, size_t size) {
+    twlcdcReplay *replay = userdata;
+
+    if (bank != CDC_TOUCHDATA) {
+        // Control registers read as zero, which reports the pen as down;
+        // whether a sample is valid is then decided by the recorded data.
+        memset(data, 0, size);
+    } else if (replay->position < replay->count) {
+        const u8 *record = replay->data + replay->position * TRACE_RECORD_SIZE;
+        replay->tick = traceGetLE(record, 8);
+        memset(data, 0xFF, size);
+        memcpy(data, record + 8, size < TRACE_RAW_SIZE ? size : TRACE_RAW_SIZE);
+        replay->position++;
+    } else {
+        // past the end of the capture, the pen stays up
+        memset(data, 0xFF, size);
+    }
+    return 0;
+}
+
+static Result traceReplayWrite(void* userdata, u8 bank, u8 reg, const void* data, size_t size) {
+    return 0;
+}
+
+// The tick of the last record read, so that samples carry their captured time.
+static u64 traceReplayTick(void* userdata) {
+    twlcdcReplay *replay = userdata;
+    return replay->tick;
+}
+
+void twlcdcReplayBackend(twlcdcReplay *replay, twlcdcBackend *backend) {
+    backend->readRegisters = traceReplayRead;
+    backend->writeRegisters = traceReplayWrite;
+    backend->userdata = replay;
+    backend->getTick = traceReplayTick;
+    // a recording has no CTR-mode codec to hand the TSC over from
+    backend->readCtrRegisters = NULL;
+    backend->writeCtrRegisters = NULL;
+}
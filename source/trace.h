@@ -0,0 +1,49 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc - libnds touchscreen controller on 3DS
+
+    Copyright (C) 2023 asie
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any
+    damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any
+    purpose, including commercial applications, and to alter it and
+    redistribute it freely, subject to the following restrictions:
+
+    1.	The origin of this software must not be misrepresented; you
+        must not claim that you wrote the original software. If you use
+        this software in a product, an acknowledgment in the product
+        documentation would be appreciated but is not required.
+    2.	Altered source versions must be plainly marked as such, and
+        must not be misrepresented as being the original software.
+    3.	This notice may not be removed or altered from any source
+        distribution.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_TRACE_H__
+#define __LIBTWLCDC_TRACE_H__
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "twlcdc.h"
+
+// File layout, all values little endian:
+// header: "TWLT", u16 version, u16 record size, u32 tick rate, u32 reserved
+// record: u64 tick, u8 raw CDC_TOUCHDATA buffer[40]
+#define TRACE_MAGIC       "TWLT"
+#define TRACE_VERSION     1
+#define TRACE_HEADER_SIZE 16
+#define TRACE_RAW_SIZE    40
+#define TRACE_RECORD_SIZE (8 + TRACE_RAW_SIZE)
+
+extern bool traceCapturing;
+// Capture control; must be called with the bus lock held, like the reads
+// which record into the capture.
+bool traceCaptureStart(FILE *file);
+bool traceCaptureStop(void);
+void traceCaptureRecord(const u8 *raw);
+
+#endif /* __LIBTWLCDC_TRACE_H__ */
@@ -26,119 +26,688 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <3ds.h>
 #include "twlcdc.h"
 #include "codec_internal.h"
+#include "pressure.h"
+#include "settings.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "trace.h"
+
+// Locking:
+// - busLock serializes controller access, including the APT hook's
+//   suspend/resume sequences, and guards all state touched while reading.
+// - touchTransform and touchLatest are double-buffered snapshots, so that
+//   readers neither block nor wait for a preempted writer; calibLock
+//   serializes transform writers and guards touchCalibration, while
+//   touchLatest is only written with busLock held.
+// Zero-initialized locks are valid, so they can be used before twlcdcInit().
+static RecursiveLock busLock;
+static LightLock calibLock;
 
 static bool wasInitialized = false;
+static bool wasSuspended = false;
+static bool wasSettingsLoaded = false;
 static twlcdcTouchCalibration touchCalibration;
-static s32 xscale, yscale;
-static s32 xoffset, yoffset;
 
-// thanks, Sono!
-static bool twlcdcSetCtrReadMode(bool enabled) {
-    u8 value;
-    if (R_FAILED(CDCCHK_ReadRegisters2(0x67, 0x25, &value, 1))) {
-        return false;
-    }
-    if (enabled) value |= (1 << 6); else value &= ~(1 << 6);
-    if (R_FAILED(CDCCHK_WriteRegisters2(0x67, 0x25, &value, 1))) {
-        return false;
-    }
-    return true;
-}
+// Raw-to-screen affine transform, TXY_SHIFT fractional bits:
+// px = (m[0][0] * rawx + m[0][1] * rawy + offset[0]) >> TXY_SHIFT
+typedef struct {
+    s32 m[2][2];
+    s64 offset[2];
+} twlcdcTransform;
+
+static twlcdcTransform touchTransform[2];
+static snapshotState touchTransformState;
+static twlcdcTouchSample touchLatest[2];
+static snapshotState touchLatestState;
+static twlcdcSmoother touchSmoother;
+static bool touchSmoothing = false;
+static twlcdcPressureTracker touchPressureTracker;
+static bool touchPressureTracking = false;
 
 // inner initialization - reconfiguring the SPI buses
-static bool twlcdcInitInner(void) {
-    if (!twlcdcSetCtrReadMode(false)) {
+static bool twlcdcInitInner(bool resume) {
+    if (!cdcSetCtrReadMode(false)) {
         return false;
     }
-    cdcTouchInit();
+    if (resume) {
+        cdcTouchResume();
+    } else {
+        cdcTouchInit();
+    }
     return true;
 }
 
 static void twlcdcExitInner(void) {
     cdcTouchExit();
-    twlcdcSetCtrReadMode(true);
+    cdcSetCtrReadMode(true);
 }
 
 // APT hook - handles uninitializing/reinitializing
 static aptHookCookie aptCookie;
 static void aptHookCb(APT_HookType hookType, void *param) {
+    RecursiveLock_Lock(&busLock);
     if (hookType == APTHOOK_ONSUSPEND || hookType == APTHOOK_ONEXIT) {
+        // Reads must fail until the controller is handed back to us.
+        wasSuspended = true;
         twlcdcExitInner();
     } else if (hookType == APTHOOK_ONRESTORE || hookType == APTHOOK_ONWAKEUP) {
-        twlcdcInitInner();
+        STATS_BEGIN(start);
+        twlcdcInitInner(true);
+        wasSuspended = false;
+        STATS_END(TWLCDC_STAT_RESUME, start);
     }
+    RecursiveLock_Unlock(&busLock);
+}
+
+static inline bool twlcdcBusAvailable(void) {
+    return wasInitialized && !wasSuspended;
 }
 
 // user routines
 bool twlcdcInit(void) {
+    bool result = true;
+
+    RecursiveLock_Lock(&busLock);
     if (!wasInitialized) {
-        if (R_FAILED(CFG_GetConfigInfoBlk4(sizeof(touchCalibration), 0x00040000, &touchCalibration))) {
-            return false;
+        twlcdcTouchCalibration calibration;
+
+        STATS_BEGIN(start);
+        if (wasSettingsLoaded) {
+            // the calibration was restored by twlcdcSettingsLoad()
+            result = twlcdcInitInner(false);
+        } else if (R_FAILED(CFG_GetConfigInfoBlk4(sizeof(calibration), 0x00040000, &calibration))) {
+            result = false;
+        } else {
+            twlcdcTouchSetCalibration(&calibration);
+            result = twlcdcInitInner(false);
         }
-        twlcdcTouchSetCalibration(&touchCalibration);
-        if (!twlcdcInitInner()) {
-            return false;
+        if (result) {
+            aptHook(&aptCookie, aptHookCb, NULL);
+            wasSuspended = false;
+            wasInitialized = true;
+            STATS_END(TWLCDC_STAT_INIT, start);
         }
-        aptHook(&aptCookie, aptHookCb, NULL);
-        wasInitialized = true;
     }
-    return true;
+    RecursiveLock_Unlock(&busLock);
+    return result;
 }
 
 void twlcdcExit(void) {
+    // The background threads take busLock themselves; stop them before locking.
+    twlcdcSamplerStop();
+    twlcdcPenNotifyStop();
+
+    RecursiveLock_Lock(&busLock);
     if (wasInitialized) {
+        twlcdcCaptureStop();
         aptUnhook(&aptCookie);
-        twlcdcExitInner();
+        if (!wasSuspended) {
+            twlcdcExitInner();
+        }
         wasInitialized = false;
     }
+    RecursiveLock_Unlock(&busLock);
 }
 
 twlcdcTouchCalibration *twlcdcTouchGetCalibration(void) {
     return &touchCalibration;
 }
 
+void twlcdcTouchCopyCalibration(twlcdcTouchCalibration *out) {
+    LightLock_Lock(&calibLock);
+    memcpy(out, &touchCalibration, sizeof(touchCalibration));
+    LightLock_Unlock(&calibLock);
+}
+
 #define TXY_SHIFT 19
 
-void twlcdcTouchSetCalibration(const twlcdcTouchCalibration *in) {
-    if (in != &touchCalibration) {
-        memcpy(&touchCalibration, in, sizeof(touchCalibration));
+static s32 saturate32(s64 value) {
+    return value > INT32_MAX ? INT32_MAX : (value < INT32_MIN ? INT32_MIN : value);
+}
+
+// Two-point scale and offset, computed in 64 bits so that extreme
+// calibration values cannot overflow. The scale is rounded to nearest.
+static void twlcdcTouchAxisTransform(s32 *scale, s64 *offset, s16 raw1, s16 raw2, s16 px1, s16 px2) {
+    s64 s = 0;
+
+    if (raw2 != raw1) {
+        s64 num = (s64) (px2 - px1) * (1LL << TXY_SHIFT), den = raw2 - raw1;
+        if (den < 0) {
+            num = -num;
+            den = -den;
+        }
+        s = (num + (num < 0 ? -den : den) / 2) / den;
     }
 
-    xscale = ((touchCalibration.calX2px - touchCalibration.calX1px) << TXY_SHIFT) / ((touchCalibration.calX2) - (touchCalibration.calX1));
-    yscale = ((touchCalibration.calY2px - touchCalibration.calY1px) << TXY_SHIFT) / ((touchCalibration.calY2) - (touchCalibration.calY1));
+    *scale = saturate32(s);
+    *offset = (((s64) px1 + px2) * (1LL << TXY_SHIFT) - (raw1 + raw2) * (s64) *scale) / 2 + *scale / 2;
+}
 
-    xoffset = ((touchCalibration.calX1 + touchCalibration.calX2) * xscale - ((touchCalibration.calX1px + touchCalibration.calX2px) << TXY_SHIFT)) / 2;
-    yoffset = ((touchCalibration.calY1 + touchCalibration.calY2) * yscale - ((touchCalibration.calY1px + touchCalibration.calY2px) << TXY_SHIFT)) / 2;
+// must be called with calibLock held
+static void twlcdcTouchPublishTransform(const twlcdcTransform *transform) {
+    int index = snapshotWriteBegin(&touchTransformState);
+    touchTransform[index] = *transform;
+    snapshotWriteEnd(&touchTransformState, index);
 }
 
-bool twlcdcTouchPenDown(void) {
-    if (!wasInitialized) {
+static void twlcdcTouchGetTransform(twlcdcTransform *transform) {
+    u32 seq;
+    int index;
+    do {
+        index = snapshotReadBegin(&touchTransformState, &seq);
+        *transform = touchTransform[index];
+    } while (snapshotReadRetry(&touchTransformState, index, seq));
+}
+
+void twlcdcTouchSetCalibration(const twlcdcTouchCalibration *in) {
+    twlcdcTransform transform;
+
+    LightLock_Lock(&calibLock);
+    memcpy(&touchCalibration, in, sizeof(touchCalibration));
+
+    memset(&transform, 0, sizeof(transform));
+    twlcdcTouchAxisTransform(&transform.m[0][0], &transform.offset[0],
+        touchCalibration.calX1, touchCalibration.calX2, touchCalibration.calX1px, touchCalibration.calX2px);
+    twlcdcTouchAxisTransform(&transform.m[1][1], &transform.offset[1],
+        touchCalibration.calY1, touchCalibration.calY2, touchCalibration.calY1px, touchCalibration.calY2px);
+    twlcdcTouchPublishTransform(&transform);
+    LightLock_Unlock(&calibLock);
+}
+
+bool twlcdcTouchSetCalibrationPoints(const twlcdcCalibrationPoint *points, size_t count) {
+    double ata[3][3] = {{0}};
+    double atb[2][3] = {{0}};
+    double mean[4] = {0};
+    double det, inv[3][3];
+    twlcdcTransform transform;
+    size_t i;
+    int j, k;
+
+    if (count < 3 || count > 9) {
         return false;
     }
 
-    return cdcTouchPenDown();
-}
+    // Least-squares fit of px = a * rawx + b * rawy + c (and likewise for py),
+    // solved through the 3x3 normal equations. This is only done once, so
+    // there is no need to avoid floating point here.
+    for (i = 0; i < count; i++) {
+        double v[3] = { points[i].rawx, points[i].rawy, 1.0 };
+        for (j = 0; j < 3; j++) {
+            for (k = 0; k < 3; k++) {
+                ata[j][k] += v[j] * v[k];
+            }
+            atb[0][j] += v[j] * points[i].px;
+            atb[1][j] += v[j] * points[i].py;
+        }
+        mean[0] += points[i].rawx;
+        mean[1] += points[i].rawy;
+        mean[2] += points[i].px;
+        mean[3] += points[i].py;
+    }
+    for (j = 0; j < 4; j++) {
+        mean[j] /= count;
+    }
 
-bool twlcdcTouchRead(twlcdcTouchPosition* pos) {
-    if (!wasInitialized) {
+    for (j = 0; j < 3; j++) {
+        for (k = 0; k < 3; k++) {
+            inv[k][j] = ata[(j + 1) % 3][(k + 1) % 3] * ata[(j + 2) % 3][(k + 2) % 3]
+                - ata[(j + 1) % 3][(k + 2) % 3] * ata[(j + 2) % 3][(k + 1) % 3];
+        }
+    }
+    det = ata[0][0] * inv[0][0] + ata[0][1] * inv[1][0] + ata[0][2] * inv[2][0];
+    // the points are (nearly) collinear
+    if (det < 1.0) {
         return false;
     }
 
-    if (!cdcTouchRead(pos)) {
+    for (i = 0; i < 2; i++) {
+        double coef[3];
+        for (j = 0; j < 3; j++) {
+            coef[j] = (inv[j][0] * atb[i][0] + inv[j][1] * atb[i][1] + inv[j][2] * atb[i][2]) / det;
+        }
+        transform.m[i][0] = saturate32(llround(coef[0] * (1 << TXY_SHIFT)));
+        transform.m[i][1] = saturate32(llround(coef[1] * (1 << TXY_SHIFT)));
+        // The least-squares plane passes through the centroid of the points;
+        // pinning the offset there rather than rounding coef[2] keeps the
+        // rounding error of the matrix centred on the calibrated area, as
+        // the two-point path does. Like it, evaluate at the middle of each
+        // ADC step.
+        transform.offset[i] = llround(mean[2 + i] * (1 << TXY_SHIFT)
+            - mean[0] * transform.m[i][0] - mean[1] * transform.m[i][1])
+            + ((s64) transform.m[i][0] + transform.m[i][1]) / 2;
+    }
+
+    LightLock_Lock(&calibLock);
+    twlcdcTouchPublishTransform(&transform);
+    LightLock_Unlock(&calibLock);
+    return true;
+}
+
+// Scan timer (0x0F): bit 7 enables it, bits 4-6 select the interval in
+// milliseconds, with 0 standing for 8 ms.
+static const twlcdcTscConfig tscProfiles[] = {
+    [TWLCDC_PROFILE_DEFAULT] = {
+        .clockDivider = 3, .conversionMode = 0x8B,
+        .prechargeTime = 4, .senseTime = 6, .stabilizationTime = 4,
+        .bufferTrigger = 5, .scanTimer = 0xA0, .scanTimerClock = 0
+    },
+    [TWLCDC_PROFILE_LOW_LATENCY] = {
+        .clockDivider = 1, .conversionMode = 0x8B,
+        .prechargeTime = 2, .senseTime = 3, .stabilizationTime = 2,
+        .bufferTrigger = 5, .scanTimer = 0x90, .scanTimerClock = 0
+    },
+    [TWLCDC_PROFILE_LOW_POWER] = {
+        .clockDivider = 3, .conversionMode = 0x8B,
+        .prechargeTime = 4, .senseTime = 6, .stabilizationTime = 4,
+        .bufferTrigger = 5, .scanTimer = 0x80, .scanTimerClock = 0
+    },
+    [TWLCDC_PROFILE_HIGH_ACCURACY] = {
+        .clockDivider = 3, .conversionMode = 0x8B,
+        .prechargeTime = 6, .senseTime = 7, .stabilizationTime = 6,
+        .bufferTrigger = 5, .scanTimer = 0xA0, .scanTimerClock = 0
+    }
+};
+
+bool twlcdcSetProfile(twlcdcProfile profile) {
+    if ((size_t) profile >= sizeof(tscProfiles) / sizeof(tscProfiles[0])) {
         return false;
     }
 
-    s16 px = (pos->rawx * xscale - xoffset + xscale/2) >> TXY_SHIFT;
-    s16 py = (pos->rawy * yscale - yoffset + yscale/2) >> TXY_SHIFT;
+    twlcdcSetTscConfig(&tscProfiles[profile]);
+    return true;
+}
+
+void twlcdcGetTscConfig(twlcdcTscConfig* config) {
+    cdcTouchGetConfig(config);
+}
+
+void twlcdcSetTscConfig(const twlcdcTscConfig* config) {
+    RecursiveLock_Lock(&busLock);
+    cdcTouchSetConfig(config, twlcdcBusAvailable());
+    RecursiveLock_Unlock(&busLock);
+}
+
+void twlcdcTouchSetFilter(twlcdcFilter filter, u16 maxSpread) {
+    RecursiveLock_Lock(&busLock);
+    cdcTouchSetFilter(filter, maxSpread);
+    RecursiveLock_Unlock(&busLock);
+}
+
+// must be called with busLock held; pos may be NULL if the pen is up,
+// in which case the last pen-down position is kept
+static void twlcdcTouchPublishLatest(const twlcdcTouchPosition* pos, bool penDown) {
+    const twlcdcTouchSample *last = &touchLatest[touchLatestState.index & 1];
+    twlcdcTouchSample sample;
+    int index;
+
+    if (!penDown && !last->penDown) {
+        // only the pen-up edge needs publishing
+        return;
+    }
+
+    sample.tick = cdcGetTick();
+    sample.pos = penDown ? *pos : last->pos;
+    sample.penDown = penDown;
+
+    index = snapshotWriteBegin(&touchLatestState);
+    touchLatest[index] = sample;
+    snapshotWriteEnd(&touchLatestState, index);
+}
+
+bool twlcdcTouchPenDown(void) {
+    bool result = false;
+
+    RecursiveLock_Lock(&busLock);
+    if (twlcdcBusAvailable()) {
+        STATS_BEGIN(start);
+        result = cdcTouchPenDown();
+        STATS_END(TWLCDC_STAT_PEN_DOWN, start);
+    }
+    if (!result) {
+        // the next position starts a new stroke
+        twlcdcSmootherReset(&touchSmoother);
+        twlcdcTouchPublishLatest(NULL, false);
+    }
+    RecursiveLock_Unlock(&busLock);
+    return result;
+}
+
+static inline s32 twlcdcTouchTransformAxis(const twlcdcTransform* t, const twlcdcTouchPosition* pos, int axis) {
+    s64 value = ((s64) t->m[axis][0] * pos->rawx + (s64) t->m[axis][1] * pos->rawy + t->offset[axis]) >> (TXY_SHIFT - 16);
+
+    return value > INT32_MAX ? INT32_MAX : (value < INT32_MIN ? INT32_MIN : value);
+}
+
+static inline void twlcdcTouchClamp(twlcdcTouchPosition* pos, s32 x, s32 y) {
+    s32 px = x >> 16;
+    s32 py = y >> 16;
 
     if (px < 0) px = 0; else if (px >= GSP_SCREEN_HEIGHT_BOTTOM) px = GSP_SCREEN_HEIGHT_BOTTOM - 1;
     if (py < 0) py = 0; else if (py >= GSP_SCREEN_WIDTH) py = GSP_SCREEN_WIDTH - 1;
 
     pos->px = px;
     pos->py = py;
+}
+
+static void twlcdcTouchTransform(twlcdcTouchPosition* pos, s32* fx, s32* fy) {
+    twlcdcTransform transform;
+    twlcdcTouchGetTransform(&transform);
+
+    // 16.16 fixed point screen coordinates
+    s32 x = twlcdcTouchTransformAxis(&transform, pos, 0);
+    s32 y = twlcdcTouchTransformAxis(&transform, pos, 1);
+
+    if (touchSmoothing) {
+        twlcdcSmootherApply(&touchSmoother, &x, &y, cdcGetTick());
+    }
+
+    twlcdcTouchClamp(pos, x, y);
+    *fx = x;
+    *fy = y;
+}
+
+void twlcdcTouchConvertBatch(const twlcdcTouchPosition* in, twlcdcTouchPosition* out, size_t count) {
+    twlcdcTransform transform;
+    size_t i;
+
+    // One transform snapshot for the whole batch; this also guarantees that
+    // all of it is converted with the same calibration.
+    twlcdcTouchGetTransform(&transform);
+
+    for (i = 0; i < count; i++) {
+        twlcdcTouchPosition pos = in[i];
+        twlcdcTouchClamp(&pos,
+            twlcdcTouchTransformAxis(&transform, &pos, 0),
+            twlcdcTouchTransformAxis(&transform, &pos, 1));
+        out[i] = pos;
+    }
+}
+
+void twlcdcTouchSetSmoothing(const twlcdcSmootherConfig *config) {
+    RecursiveLock_Lock(&busLock);
+    if (config != NULL) {
+        twlcdcSmootherInit(&touchSmoother, config);
+    }
+    touchSmoothing = config != NULL;
+    RecursiveLock_Unlock(&busLock);
+}
+
+// must be called with busLock held
+static bool twlcdcTouchReadInner(twlcdcTouchPosition* pos, s32* fx, s32* fy) {
+    bool result = false;
+
+    if (twlcdcBusAvailable()) {
+        STATS_BEGIN(start);
+        result = cdcTouchRead(pos);
+        if (result) {
+            twlcdcTouchTransform(pos, fx, fy);
+            twlcdcTouchPublishLatest(pos, true);
+        }
+        STATS_END(TWLCDC_STAT_READ, start);
+    }
+    if (!result) {
+        twlcdcSmootherReset(&touchSmoother);
+        twlcdcTouchPublishLatest(NULL, false);
+    }
+    return result;
+}
+
+bool twlcdcTouchRead(twlcdcTouchPosition* pos) {
+    bool result;
+    s32 fx, fy;
+
+    RecursiveLock_Lock(&busLock);
+    result = twlcdcTouchReadInner(pos, &fx, &fy);
+    RecursiveLock_Unlock(&busLock);
+    return result;
+}
+
+// must be called with busLock held
+static void twlcdcTouchFillEx(twlcdcTouchPositionEx* pos) {
+    pos->resistance = pressureResistance(pos->pos.rawx, pos->pos.z1, pos->pos.z2);
+    pos->pressure = pressureFromResistance(pos->resistance);
+    pos->level = 0;
+    if (touchPressureTracking) {
+        twlcdcPressureTrackerUpdate(&touchPressureTracker, pos->resistance);
+        pos->level = twlcdcPressureTrackerNormalize(&touchPressureTracker, pos->resistance);
+    }
+    pos->flags = (pos->fx < 0 ? TWLCDC_POSITION_OFF_LEFT : 0)
+        | (pos->fx >= (GSP_SCREEN_HEIGHT_BOTTOM << 16) ? TWLCDC_POSITION_OFF_RIGHT : 0)
+        | (pos->fy < 0 ? TWLCDC_POSITION_OFF_TOP : 0)
+        | (pos->fy >= (GSP_SCREEN_WIDTH << 16) ? TWLCDC_POSITION_OFF_BOTTOM : 0);
+}
+
+bool twlcdcTouchReadEx(twlcdcTouchPositionEx* pos) {
+    bool result;
+
+    RecursiveLock_Lock(&busLock);
+    result = twlcdcTouchReadInner(&pos->pos, &pos->fx, &pos->fy);
+    if (result) {
+        twlcdcTouchFillEx(pos);
+    }
+    RecursiveLock_Unlock(&busLock);
+    return result;
+}
+
+size_t twlcdcTouchReadSamples(twlcdcTouchPosition* out, size_t max) {
+    twlcdcTouchPosition samples[TWLCDC_TOUCH_SAMPLES_PER_READ];
+    size_t count = 0;
+
+    if (max == 0) {
+        // nothing to read into; do not spend a controller read on it
+        return 0;
+    }
+
+    RecursiveLock_Lock(&busLock);
+    if (twlcdcBusAvailable()) {
+        STATS_BEGIN(start);
+        count = cdcTouchReadSamples(samples, max < TWLCDC_TOUCH_SAMPLES_PER_READ ? max : TWLCDC_TOUCH_SAMPLES_PER_READ);
+        if (count > 0) {
+            // Individual samples bypass smoothing, which assumes one
+            // sample per read.
+            twlcdcTouchConvertBatch(samples, out, count);
+            twlcdcTouchPublishLatest(&out[count - 1], true);
+        }
+        STATS_END(TWLCDC_STAT_READ, start);
+    }
+    if (count == 0) {
+        twlcdcTouchPublishLatest(NULL, false);
+    }
+    RecursiveLock_Unlock(&busLock);
+    return count;
+}
+
+bool twlcdcTouchGetLatest(twlcdcTouchSample* sample) {
+    u32 seq;
+    int index;
+    do {
+        index = snapshotReadBegin(&touchLatestState, &seq);
+        *sample = touchLatest[index];
+    } while (snapshotReadRetry(&touchLatestState, index, seq));
+    return sample->penDown;
+}
+
+void twlcdcTouchGetPressureModel(twlcdcPressureModel* model) {
+    RecursiveLock_Lock(&busLock);
+    pressureGetModel(model);
+    RecursiveLock_Unlock(&busLock);
+}
+
+void twlcdcTouchSetPressureModel(const twlcdcPressureModel* model) {
+    RecursiveLock_Lock(&busLock);
+    pressureSetModel(model);
+    RecursiveLock_Unlock(&busLock);
+}
+
+void twlcdcTouchSetPressureTracking(const twlcdcPressureTracker* tracker) {
+    RecursiveLock_Lock(&busLock);
+    if (tracker != NULL) {
+        touchPressureTracker = *tracker;
+    }
+    touchPressureTracking = tracker != NULL;
+    RecursiveLock_Unlock(&busLock);
+}
+
+bool twlcdcTouchGetPressureTracking(twlcdcPressureTracker* tracker) {
+    bool result;
+
+    RecursiveLock_Lock(&busLock);
+    *tracker = touchPressureTracker;
+    result = touchPressureTracking;
+    RecursiveLock_Unlock(&busLock);
+    return result;
+}
+
+size_t twlcdcSettingsSave(void* buffer, size_t size) {
+    settingsState state;
+    twlcdcTransform transform;
+
+    if (size < TWLCDC_SETTINGS_SIZE) {
+        return 0;
+    }
+
+    memset(&state, 0, sizeof(state));
+    RecursiveLock_Lock(&busLock);
+    LightLock_Lock(&calibLock);
+    state.calibration = touchCalibration;
+    twlcdcTouchGetTransform(&transform);
+    LightLock_Unlock(&calibLock);
+    memcpy(state.m, transform.m, sizeof(state.m));
+    memcpy(state.offset, transform.offset, sizeof(state.offset));
+    cdcTouchGetFilter(&state.filter, &state.maxSpread);
+    cdcTouchGetConfig(&state.tscConfig);
+    pressureGetModel(&state.pressureModel);
+    state.flags = touchPressureTracking ? SETTINGS_FLAG_PRESSURE_TRACKING : 0;
+    state.pressureTracker = touchPressureTracker;
+    RecursiveLock_Unlock(&busLock);
+
+    settingsEncode(&state, buffer);
+    return TWLCDC_SETTINGS_SIZE;
+}
+
+bool twlcdcSettingsLoad(const void* buffer, size_t size) {
+    settingsState state;
+    twlcdcTransform transform;
 
+    if (!settingsDecode(&state, buffer, size)) {
+        return false;
+    }
+
+    memcpy(transform.m, state.m, sizeof(transform.m));
+    memcpy(transform.offset, state.offset, sizeof(transform.offset));
+
+    RecursiveLock_Lock(&busLock);
+    LightLock_Lock(&calibLock);
+    touchCalibration = state.calibration;
+    twlcdcTouchPublishTransform(&transform);
+    LightLock_Unlock(&calibLock);
+    cdcTouchSetFilter(state.filter, state.maxSpread);
+    cdcTouchSetConfig(&state.tscConfig, twlcdcBusAvailable());
+    pressureSetModel(&state.pressureModel);
+    touchPressureTracker = state.pressureTracker;
+    touchPressureTracking = (state.flags & SETTINGS_FLAG_PRESSURE_TRACKING) != 0;
+    wasSettingsLoaded = true;
+    RecursiveLock_Unlock(&busLock);
     return true;
 }
+
+bool twlcdcSettingsSaveFile(FILE* file) {
+    u8 buffer[TWLCDC_SETTINGS_SIZE];
+
+    twlcdcSettingsSave(buffer, sizeof(buffer));
+    return fwrite(buffer, sizeof(buffer), 1, file) == 1;
+}
+
+bool twlcdcSettingsLoadFile(FILE* file) {
+    u8 buffer[TWLCDC_SETTINGS_SIZE];
+
+    if (fread(buffer, sizeof(buffer), 1, file) != 1) {
+        return false;
+    }
+    return twlcdcSettingsLoad(buffer, sizeof(buffer));
+}
+
+// must be called with busLock held
+static bool twlcdcTouchPollInner(twlcdcTouchPosition* pos, s32* fx, s32* fy, twlcdcPollMode mode) {
+    bool result = false;
+
+    if (twlcdcBusAvailable()) {
+        STATS_BEGIN(start);
+        // With the pen up, the data buffer fails the validity check, which
+        // lets TWLCDC_POLL_FAST skip the status registers altogether.
+        result = (mode != TWLCDC_POLL_CHECKED || cdcTouchPenDown()) && cdcTouchRead(pos);
+        if (result) {
+            twlcdcTouchTransform(pos, fx, fy);
+            twlcdcTouchPublishLatest(pos, true);
+        }
+        STATS_END(TWLCDC_STAT_POLL, start);
+    }
+    if (!result) {
+        twlcdcSmootherReset(&touchSmoother);
+        twlcdcTouchPublishLatest(NULL, false);
+    }
+    return result;
+}
+
+bool twlcdcTouchPoll(twlcdcTouchPosition* pos, twlcdcPollMode mode) {
+    bool result;
+    s32 fx, fy;
+
+    RecursiveLock_Lock(&busLock);
+    result = twlcdcTouchPollInner(pos, &fx, &fy, mode);
+    RecursiveLock_Unlock(&busLock);
+    return result;
+}
+
+bool twlcdcTouchPollEx(twlcdcTouchPositionEx* pos, twlcdcPollMode mode) {
+    bool result;
+
+    RecursiveLock_Lock(&busLock);
+    result = twlcdcTouchPollInner(&pos->pos, &pos->fx, &pos->fy, mode);
+    if (result) {
+        twlcdcTouchFillEx(pos);
+    }
+    RecursiveLock_Unlock(&busLock);
+    return result;
+}
+
+void twlcdcEventPoll(twlcdcEventTracker *tracker, twlcdcPollMode mode) {
+    twlcdcTouchSample sample;
+
+    sample.penDown = twlcdcTouchPoll(&sample.pos, mode);
+    sample.tick = cdcGetTick();
+    twlcdcEventFeed(tracker, &sample);
+}
+
+void twlcdcSetBackend(const twlcdcBackend* backend) {
+    RecursiveLock_Lock(&busLock);
+    cdcSetBackend(backend);
+    RecursiveLock_Unlock(&busLock);
+}
+
+bool twlcdcCaptureStart(FILE *file) {
+    bool result;
+
+    // reads record into the capture, so it must not change under them
+    RecursiveLock_Lock(&busLock);
+    result = traceCaptureStart(file);
+    RecursiveLock_Unlock(&busLock);
+    return result;
+}
+
+bool twlcdcCaptureStop(void) {
+    bool result;
+
+    RecursiveLock_Lock(&busLock);
+    result = traceCaptureStop();
+    RecursiveLock_Unlock(&busLock);
+    return result;
+}
+
+u32 twlcdcGetIpcCount(void) {
+    return cdcGetIpcCount();
+}
@@ -0,0 +1,34 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host benchmarks - timing and reporting helpers
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_BENCH_H__
+#define __LIBTWLCDC_BENCH_H__
+
+#include <stdio.h>
+#include <time.h>
+
+static int benchFailures;
+
+// Wall-clock time in nanoseconds, independent of the simulated system tick.
+static inline double benchNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Prints one CSV row (benchmark,metric,value,limit) and records a failure if
+// the value exceeds the limit. A limit of 0 means "report only".
+static inline void benchReport(const char *bench, const char *metric, double value, double limit) {
+    printf("%s,%s,%.2f,%.2f\n", bench, metric, value, limit);
+    if (limit > 0 && value > limit) {
+        fprintf(stderr, "%s: %s = %.2f exceeds %.2f\n", bench, metric, value, limit);
+        benchFailures++;
+    }
+}
+
+#define BENCH_RESULT() (benchFailures == 0 ? 0 : 1)
+
+#endif /* __LIBTWLCDC_BENCH_H__ */
@@ -0,0 +1,54 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host benchmarks - batch raw-to-screen conversion
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "bench.h"
+
+#define COUNT 4096
+#define ROUNDS 2000
+
+static const twlcdcTouchCalibration calibration = {
+    0x1F0, 0x2E0, 32, 24, 0xE10, 0xD30, 288, 216
+};
+
+int main(void) {
+    static twlcdcTouchPosition raw[COUNT], out[COUNT];
+    volatile u32 sink = 0;
+    double start, elapsed;
+    u32 seed = 1;
+    int i;
+
+    hostReset();
+    twlcdcTouchSetCalibration(&calibration);
+    for (i = 0; i < COUNT; i++) {
+        seed = seed * 1103515245 + 12345;
+        memset(&raw[i], 0, sizeof(raw[i]));
+        raw[i].rawx = (seed >> 4) & 0xFFF;
+        raw[i].rawy = (seed >> 16) & 0xFFF;
+    }
+
+    // a stroke buffer at a time, as replay and post-processing use it
+    start = benchNow();
+    for (i = 0; i < ROUNDS; i++) {
+        twlcdcTouchConvertBatch(raw, out, COUNT);
+        sink += out[i & (COUNT - 1)].px;
+    }
+    elapsed = benchNow() - start;
+    benchReport("batch", "ns_per_sample", elapsed / ((double) ROUNDS * COUNT), 20);
+
+    // one position per call, which pays for the calibration snapshot each time
+    start = benchNow();
+    for (i = 0; i < ROUNDS * COUNT / 16; i++) {
+        twlcdcTouchConvertBatch(&raw[i & (COUNT - 1)], &out[i & (COUNT - 1)], 1);
+        sink += out[i & (COUNT - 1)].py;
+    }
+    elapsed = benchNow() - start;
+    benchReport("batch", "ns_per_single_call", elapsed / (ROUNDS * COUNT / 16), 50);
+
+    return sink == 0 ? 1 : BENCH_RESULT();
+}
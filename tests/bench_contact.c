@@ -0,0 +1,175 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host benchmarks - dual contact classifier evaluation
+
+    Runs the classifier over strokes generated by a simple model of a
+    4-wire resistive panel, and reports how often single contacts are
+    misclassified as dual (false positives), how often dual contacts are
+    missed, and the cost per classification.
+
+---------------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "pressure.h"
+#include "bench.h"
+
+#define TRIALS 2000
+#define SETS 5
+
+// 8 raw steps per pixel
+static const twlcdcTouchCalibration calibration = {
+    0x100, 0x100, 0, 0, 0xB00, 0x880, 320, 240
+};
+
+static const twlcdcContactConfig config = {
+    .dualRatio = 39322,
+    .baselineWeight = 6554,
+    .separationScale = 200,
+    .maxSpread = 48,
+    .jumpDistance = 12
+};
+
+static u32 seed = 1;
+
+static double uniform(double min, double max) {
+    seed = seed * 1103515245 + 12345;
+    return min + (max - min) * ((seed >> 8) & 0xFFFF) / 65535.0;
+}
+
+// Touch resistance relative to the X plate, for a contact at a given
+// pressure between 0 and 1; it falls as the contact area grows.
+static double panelResistance(double pressure) {
+    return 0.15 / pressure;
+}
+
+// One read of five sample sets for a contact at (x, y) pixels with the
+// given relative touch resistance, with conversion noise.
+static void panelRead(twlcdcTouchPosition *out, double x, double y, double resistance) {
+    int i;
+
+    for (i = 0; i < SETS; i++) {
+        double rawx = 0x100 + x * 8 + uniform(-3, 3);
+        double rawy = 0x100 + y * 8 + uniform(-3, 3);
+        double ratio = 1 + resistance * 4096 / rawx;
+        double z1 = fmin(0x300, 4000 / ratio);
+
+        memset(&out[i], 0, sizeof(out[i]));
+        out[i].rawx = rawx;
+        out[i].rawy = rawy;
+        out[i].z1 = z1 * uniform(0.99, 1.01);
+        out[i].z2 = z1 * ratio * uniform(0.99, 1.01);
+    }
+    twlcdcTouchConvertBatch(out, out, SETS);
+}
+
+typedef struct {
+    u32 singleReads, falseDual;
+    u32 dualReads, missedDual;
+    u32 classified;
+    double elapsed;
+} evalResult;
+
+static twlcdcContactType classify(twlcdcContactClassifier *classifier, const twlcdcTouchPosition *samples, size_t count, evalResult *result) {
+    twlcdcContact contact;
+    twlcdcContactType type;
+    double start = benchNow();
+
+    type = twlcdcContactClassify(classifier, samples, count, &contact);
+    result->elapsed += benchNow() - start;
+    result->classified++;
+    return type;
+}
+
+static void single(twlcdcContactClassifier *classifier, const twlcdcTouchPosition *samples, evalResult *result) {
+    result->singleReads++;
+    result->falseDual += classify(classifier, samples, SETS, result) == TWLCDC_CONTACT_DUAL;
+}
+
+// A single contact: pressure ramps from light to firm within rampReads
+// reads, then wobbles, while the pen moves at up to speed pixels per read.
+static void strokeSingle(evalResult *result, int rampReads, double speed) {
+    twlcdcContactClassifier classifier;
+    twlcdcTouchPosition samples[SETS];
+    double x = uniform(60, 260), y = uniform(60, 180);
+    double angle = uniform(0, 2 * M_PI);
+    double start = uniform(0.15, 0.3);
+    int i;
+
+    twlcdcContactInit(&classifier, &config);
+    for (i = 0; i < 60; i++) {
+        double pressure = i < rampReads ? start + (1 - start) * i / rampReads : uniform(0.8, 1);
+        panelRead(samples, x, y, panelResistance(pressure));
+        single(&classifier, samples, result);
+        angle += uniform(-0.3, 0.3);
+        x = fmin(fmax(x + cos(angle) * speed, 10), 310);
+        y = fmin(fmax(y + sin(angle) * speed, 10), 230);
+    }
+    classify(&classifier, NULL, 0, result);
+}
+
+// A single contact, joined by a second one at a random distance for a
+// while: the panel reports their midpoint at a lower resistance.
+static void strokeDual(evalResult *result) {
+    twlcdcContactClassifier classifier;
+    twlcdcTouchPosition samples[SETS];
+    double x = uniform(100, 220), y = uniform(80, 160);
+    double separation = uniform(30, 160), angle = uniform(0, 2 * M_PI);
+    double mx = x + cos(angle) * separation / 2, my = y + sin(angle) * separation / 2;
+    double drop = uniform(0.25, 0.5);
+    int i;
+
+    twlcdcContactInit(&classifier, &config);
+    for (i = 0; i < 20; i++) {
+        panelRead(samples, x, y, panelResistance(uniform(0.68, 0.75)));
+        single(&classifier, samples, result);
+    }
+    for (i = 0; i < 30; i++) {
+        panelRead(samples, mx, my, panelResistance(uniform(0.68, 0.75)) * drop);
+        result->dualReads++;
+        result->missedDual += classify(&classifier, samples, SETS, result) != TWLCDC_CONTACT_DUAL;
+    }
+    classify(&classifier, NULL, 0, result);
+}
+
+static void report(const char *metric, u32 count, u32 total, double limit) {
+    benchReport("contact", metric, total ? 100.0 * count / total : 0, limit);
+}
+
+int main(void) {
+    evalResult still, pressing, moving, pressingMoving, dual, all;
+    int i;
+
+    twlcdcTouchSetCalibration(&calibration);
+    memset(&still, 0, sizeof(still));
+    memset(&pressing, 0, sizeof(pressing));
+    memset(&moving, 0, sizeof(moving));
+    memset(&pressingMoving, 0, sizeof(pressingMoving));
+    memset(&dual, 0, sizeof(dual));
+
+    for (i = 0; i < TRIALS; i++) {
+        strokeSingle(&still, 30, 0.5);
+        strokeSingle(&pressing, (int) uniform(2, 12), 0.5);
+        strokeSingle(&moving, 30, uniform(10, 30));
+        strokeSingle(&pressingMoving, (int) uniform(2, 12), uniform(10, 30));
+        strokeDual(&dual);
+    }
+
+    // false positives, in percent of single contact reads
+    report("false_dual_pct_still", still.falseDual, still.singleReads, 0.01);
+    report("false_dual_pct_pressing", pressing.falseDual, pressing.singleReads, 0.01);
+    report("false_dual_pct_moving", moving.falseDual, moving.singleReads, 0.01);
+    report("false_dual_pct_pressing_moving", pressingMoving.falseDual, pressingMoving.singleReads, 0.01);
+    report("false_dual_pct_before_second", dual.falseDual, dual.singleReads, 0.01);
+
+    // missed dual contacts, in percent of dual contact reads
+    report("missed_dual_pct", dual.missedDual, dual.dualReads, 1);
+
+    all = still;
+    all.elapsed += pressing.elapsed + moving.elapsed + pressingMoving.elapsed + dual.elapsed;
+    all.classified += pressing.classified + moving.classified + pressingMoving.classified + dual.classified;
+    benchReport("contact", "ns_per_classify", all.elapsed / all.classified, 500);
+
+    return BENCH_RESULT();
+}
@@ -0,0 +1,45 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host benchmarks - per-reading cost of the reduction filters
+
+---------------------------------------------------------------------------------*/
+
+#include "twlcdc.h"
+#include "filter.h"
+#include "bench.h"
+
+#define ITERATIONS 10000000
+#define INPUTS 1024
+
+int main(void) {
+    static const char *names[] = { "mean", "median", "trimmed_mean", "reject_spread" };
+    static u16 inputs[INPUTS][5];
+    volatile u32 sink = 0;
+    u32 seed = 1;
+    int f, i, j;
+
+    for (i = 0; i < INPUTS; i++) {
+        for (j = 0; j < 5; j++) {
+            seed = seed * 1103515245 + 12345;
+            inputs[i][j] = 0x800 + ((seed >> 16) & 0x3F);
+        }
+    }
+
+    for (f = TWLCDC_FILTER_MEAN; f <= TWLCDC_FILTER_REJECT_SPREAD; f++) {
+        double start = benchNow(), elapsed;
+        u32 acc = 0;
+
+        for (i = 0; i < ITERATIONS; i++) {
+            const u16 *v = inputs[i & (INPUTS - 1)];
+            if (f == TWLCDC_FILTER_REJECT_SPREAD) {
+                acc += filterSpread5(v);
+            }
+            acc += filterReduce5(v, f);
+        }
+        elapsed = benchNow() - start;
+        sink += acc;
+        benchReport("filter", names[f], elapsed / ITERATIONS, 50);
+    }
+
+    return sink == 0 ? 1 : BENCH_RESULT();
+}
@@ -0,0 +1,48 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host benchmarks - sample ring push/drain cost
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "ring.h"
+#include "bench.h"
+
+#define ITERATIONS 10000000
+
+int main(void) {
+    static ringSample storage[256];
+    ringSample sample, out[32];
+    twlcdcRing ring;
+    volatile uint64_t sink = 0;
+    double start, elapsed;
+    uint32_t i;
+
+    memset(&sample, 0, sizeof(sample));
+    ringInit(&ring, storage, 256);
+
+    // one push and one single-record drain per iteration
+    start = benchNow();
+    for (i = 0; i < ITERATIONS; i++) {
+        sample.tick = i;
+        ringPush(&ring, &sample);
+        sink += ringDrain(&ring, out, 1);
+    }
+    elapsed = benchNow() - start;
+    benchReport("ring", "ns_per_push_drain", elapsed / ITERATIONS, 50);
+
+    // a frame's worth of samples drained at once
+    start = benchNow();
+    for (i = 0; i < ITERATIONS / 32; i++) {
+        uint32_t j;
+        for (j = 0; j < 32; j++) {
+            sample.tick = j;
+            ringPush(&ring, &sample);
+        }
+        sink += ringDrain(&ring, out, 32);
+    }
+    elapsed = benchNow() - start;
+    benchReport("ring", "ns_per_sample_batched", elapsed / ITERATIONS, 50);
+
+    return sink == 0 ? 1 : BENCH_RESULT();
+}
@@ -0,0 +1,91 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host benchmarks - smoothing filter cost, jitter and lag
+
+---------------------------------------------------------------------------------*/
+
+#include <math.h>
+#include "twlcdc.h"
+#include "bench.h"
+
+#define TICKS_PER_MS (SYSCLOCK_ARM11 / 1000)
+#define ITERATIONS 5000000
+#define PX(v) ((s32) ((v) * 65536.0))
+
+static u32 seed = 1;
+
+static s32 noise(double amplitude) {
+    seed = seed * 1103515245 + 12345;
+    return PX(((seed >> 8) & 0xFFFF) / 32768.0 * amplitude - amplitude);
+}
+
+// RMS deviation from a stationary point with 1.5 px of noise, in pixels.
+static double jitter(const twlcdcSmootherConfig *config) {
+    twlcdcSmoother smoother;
+    double sum = 0;
+    int i;
+
+    if (config != NULL) {
+        twlcdcSmootherInit(&smoother, config);
+    }
+    for (i = 0; i < 2000; i++) {
+        s32 x = PX(160) + noise(1.5), y = PX(120) + noise(1.5);
+        if (config != NULL) {
+            twlcdcSmootherApply(&smoother, &x, &y, i * TICKS_PER_MS);
+        }
+        if (i >= 200) {
+            sum += pow((x - PX(160)) / 65536.0, 2);
+        }
+    }
+    return sqrt(sum / 1800);
+}
+
+// Mean distance behind a noisy pen moving at `speed` px/s, in pixels; with
+// prediction, behind where the pen will be at the end of the horizon.
+static double lag(const twlcdcSmootherConfig *config, double speed) {
+    twlcdcSmoother smoother;
+    double sum = 0;
+    int i;
+
+    twlcdcSmootherInit(&smoother, config);
+    for (i = 0; i < 500; i++) {
+        double truth = 10 + speed * (i / 1000.0 + config->predictUs / 1000000.0);
+        s32 x = PX(10 + speed * i / 1000.0) + noise(1.5), y = PX(120);
+        twlcdcSmootherApply(&smoother, &x, &y, i * TICKS_PER_MS);
+        if (i >= 100) {
+            sum += truth - x / 65536.0;
+        }
+    }
+    return sum / 400;
+}
+
+int main(void) {
+    static const twlcdcSmootherConfig plain = { .minCutoff = 1 << 8, .beta = 6554 };
+    static const twlcdcSmootherConfig predict = {
+        .minCutoff = 1 << 8, .beta = 6554,
+        .predictUs = 16000, .alphaGain = 0x8000, .betaGain = 0x1999
+    };
+    twlcdcSmoother smoother;
+    volatile s32 sink = 0;
+    double start, elapsed;
+    int i;
+
+    twlcdcSmootherInit(&smoother, &predict);
+    start = benchNow();
+    for (i = 0; i < ITERATIONS; i++) {
+        s32 x = PX(100) + (i & 0xFFFF), y = PX(100) - (i & 0xFFFF);
+        twlcdcSmootherApply(&smoother, &x, &y, (u64) i * TICKS_PER_MS);
+        sink += x + y;
+    }
+    elapsed = benchNow() - start;
+    benchReport("smooth", "ns_per_apply", elapsed / ITERATIONS, 200);
+
+    benchReport("smooth", "jitter_raw_px", jitter(NULL), 0);
+    benchReport("smooth", "jitter_px", jitter(&plain), 0.3);
+    benchReport("smooth", "lag_200pxs_px", lag(&plain, 200), 1.5);
+    benchReport("smooth", "lag_1000pxs_px", lag(&plain, 1000), 3);
+    benchReport("smooth", "lag_1000pxs_predicted_px", fabs(lag(&predict, 1000)), 1.5);
+
+    (void) sink;
+    return BENCH_RESULT();
+}
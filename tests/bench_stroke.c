@@ -0,0 +1,59 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host benchmarks - stroke resampling cost
+
+---------------------------------------------------------------------------------*/
+
+#include <math.h>
+#include "twlcdc.h"
+#include "bench.h"
+
+#define INPUTS 256
+#define ROUNDS 4000
+
+static twlcdcStrokePoint input[INPUTS];
+static twlcdcStrokePoint arena[8192];
+
+static double run(twlcdcStrokeSmoothing smoothing, size_t *outputs) {
+    twlcdcStroke stroke;
+    double start = benchNow();
+    int i, j;
+
+    *outputs = 0;
+    for (i = 0; i < ROUNDS; i++) {
+        twlcdcStrokeBegin(&stroke, arena, 8192, 2 << 16, smoothing);
+        for (j = 0; j < INPUTS; j++) {
+            twlcdcStrokeAdd(&stroke, &input[j]);
+        }
+        twlcdcStrokeEnd(&stroke);
+        *outputs += stroke.count;
+    }
+    return benchNow() - start;
+}
+
+int main(void) {
+    double angle = 0, elapsed;
+    size_t outputs;
+    u32 seed = 1;
+    int i;
+
+    // a spiral drawn at varying speed, one input point per sampler tick
+    for (i = 0; i < INPUTS; i++) {
+        double r = 20 + i * 0.3;
+        seed = seed * 1103515245 + 12345;
+        angle += 0.02 + ((seed >> 16) & 0xFF) / 255.0 * 0.1;
+        input[i].x = (s32) ((160 + r * cos(angle)) * 65536);
+        input[i].y = (s32) ((120 + r * sin(angle)) * 65536);
+        input[i].pressure = 1000 + i;
+    }
+
+    elapsed = run(TWLCDC_STROKE_LINEAR, &outputs);
+    benchReport("stroke", "linear_ns_per_input", elapsed / ((double) ROUNDS * INPUTS), 200);
+    benchReport("stroke", "linear_ns_per_output", elapsed / outputs, 0);
+
+    elapsed = run(TWLCDC_STROKE_CATMULL_ROM, &outputs);
+    benchReport("stroke", "catmull_rom_ns_per_input", elapsed / ((double) ROUNDS * INPUTS), 1000);
+    benchReport("stroke", "catmull_rom_ns_per_output", elapsed / outputs, 0);
+
+    return BENCH_RESULT();
+}
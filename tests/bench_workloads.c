@@ -0,0 +1,336 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host benchmarks - input workloads against the simulated controller
+
+    Runs the common read paths, init/exit, suspend/resume and calibration
+    over idle, tap storm and drawing workloads. Register traffic and
+    simulated bus time are deterministic, and are checked against
+    bench_baseline.csv; wall-clock cost per operation is checked against
+    the limits below, and read throughput is reported in samples per
+    second. Run with the "baseline" argument to print a new baseline
+    instead.
+
+    usage: bench_workloads [-l latency_us] [-r read_ns] [-i init_ns]
+                           [-c calibration_ns] [baseline]
+
+    -l sets the simulated cost of one register access, which defaults to
+    $TWLCDC_BENCH_LATENCY_US or BASELINE_LATENCY_US. The baseline holds
+    simulated bus time for BASELINE_LATENCY_US only, so at any other
+    latency that time is reported but not checked. -r, -i and -c replace
+    the wall-clock limits; 0 reports without checking.
+
+---------------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "bench.h"
+
+#define ITERATIONS 1000
+#define INIT_ITERATIONS 50
+#define BASELINE_FILE "bench_baseline.csv"
+#define BASELINE_MAX 64
+
+// simulated cost of one register access that bench_baseline.csv is for
+#define BASELINE_LATENCY_US 100
+
+// default wall-clock limits, in nanoseconds per operation
+#define LIMIT_READ_NS 1000
+#define LIMIT_INIT_NS 3000
+#define LIMIT_CALIBRATION_NS 200
+
+typedef enum {
+    WORKLOAD_IDLE = 0,      // pen never touches the screen
+    WORKLOAD_TAP_STORM = 1, // short taps at scattered positions
+    WORKLOAD_DRAWING = 2,   // pen held down, moving continuously
+    WORKLOAD_COUNT
+} workload;
+
+static const char *workloadNames[WORKLOAD_COUNT] = { "idle", "tap_storm", "drawing" };
+
+typedef struct {
+    char name[48];
+    char metric[24];
+    double value;
+} baselineEntry;
+
+static baselineEntry baseline[BASELINE_MAX];
+static int baselineCount;
+static bool printBaseline;
+static unsigned long latencyUs = BASELINE_LATENCY_US;
+static double limitReadNs = LIMIT_READ_NS;
+static double limitInitNs = LIMIT_INIT_NS;
+static double limitCalibrationNs = LIMIT_CALIBRATION_NS;
+
+// pen state for each operation, standing in for time
+static simPen script[ITERATIONS];
+
+static void loadBaseline(void) {
+    FILE *file = fopen(BASELINE_FILE, "r");
+    char line[128];
+
+    if (file == NULL) {
+        return;
+    }
+    while (baselineCount < BASELINE_MAX && fgets(line, sizeof(line), file) != NULL) {
+        baselineEntry *entry = &baseline[baselineCount];
+        if (sscanf(line, "%47[^,],%23[^,],%lf", entry->name, entry->metric, &entry->value) == 3) {
+            baselineCount++;
+        }
+    }
+    fclose(file);
+}
+
+// Deterministic metrics must not exceed their baseline; a missing entry
+// fails too, so that the baseline is kept in sync with the benchmarks.
+static void reportBaseline(const char *name, const char *metric, double value) {
+    int i;
+
+    if (printBaseline) {
+        printf("%s,%s,%.2f\n", name, metric, value);
+        return;
+    }
+    for (i = 0; i < baselineCount; i++) {
+        if (!strcmp(baseline[i].name, name) && !strcmp(baseline[i].metric, metric)) {
+            benchReport(name, metric, value, baseline[i].value + 0.005);
+            return;
+        }
+    }
+    fprintf(stderr, "%s: %s has no baseline in " BASELINE_FILE "\n", name, metric);
+    benchReport(name, metric, value, 0);
+    benchFailures++;
+}
+
+static void reportWall(const char *name, const char *metric, double value, double limit) {
+    if (!printBaseline) {
+        benchReport(name, metric, value, limit);
+    }
+}
+
+typedef struct {
+    const char *name;
+    u32 ipc;
+    u64 ticks;
+    double wall;
+    u32 samples;
+} measurement;
+
+static void begin(measurement *m, const char *name) {
+    m->name = name;
+    m->samples = 0;
+    m->ipc = twlcdcGetIpcCount();
+    m->ticks = svcGetSystemTick();
+    m->wall = benchNow();
+}
+
+static void end(measurement *m, u32 iterations, double limitNs) {
+    double wall = benchNow() - m->wall;
+    u64 ticks = svcGetSystemTick() - m->ticks;
+    u32 ipc = twlcdcGetIpcCount() - m->ipc;
+
+    reportBaseline(m->name, "ipc_per_op", (double) ipc / iterations);
+    if (latencyUs == BASELINE_LATENCY_US) {
+        reportBaseline(m->name, "sim_us_per_op", (double) ticks / HOST_TICKS_PER_US / iterations);
+    } else {
+        reportWall(m->name, "sim_us_per_op", (double) ticks / HOST_TICKS_PER_US / iterations, 0);
+    }
+    reportBaseline(m->name, "samples_per_op", (double) m->samples / iterations);
+    reportWall(m->name, "ns_per_op", wall / iterations, limitNs);
+    if (m->samples != 0) {
+        reportWall(m->name, "samples_per_s", m->samples * 1e9 / wall, 0);
+    }
+}
+
+static void fillScript(workload w) {
+    u32 seed = 1;
+    u16 x = 0, y = 0;
+    int i;
+
+    for (i = 0; i < ITERATIONS; i++) {
+        simPen *pen = &script[i];
+        pen->down = false;
+        pen->rawx = pen->rawy = pen->z1 = pen->z2 = 0;
+
+        if (w == WORKLOAD_TAP_STORM) {
+            // 4 operations down, 4 up
+            if ((i & 7) == 0) {
+                seed = seed * 1103515245 + 12345;
+                x = 0x200 + ((seed >> 8) & 0xBFF);
+                y = 0x200 + ((seed >> 20) & 0xBFF);
+            }
+            pen->down = (i & 4) == 0;
+        } else if (w == WORKLOAD_DRAWING) {
+            // triangle waves at different rates trace a diagonal zigzag
+            u32 tx = (i * 7) % 0x1800, ty = (i * 5) % 0x1800;
+            x = 0x200 + (tx < 0xC00 ? tx : 0x17FF - tx);
+            y = 0x200 + (ty < 0xC00 ? ty : 0x17FF - ty);
+            pen->down = true;
+        }
+        if (pen->down) {
+            pen->rawx = x;
+            pen->rawy = y;
+            pen->z1 = 0x180;
+            pen->z2 = 0x900;
+        }
+    }
+}
+
+static void benchWorkload(simTsc *sim, workload w) {
+    twlcdcTouchPosition pos;
+    measurement m;
+    char names[3][48];
+    u32 i;
+
+    snprintf(names[0], sizeof(names[0]), "pen_down_read_%s", workloadNames[w]);
+    snprintf(names[1], sizeof(names[1]), "poll_checked_%s", workloadNames[w]);
+    snprintf(names[2], sizeof(names[2]), "poll_fast_%s", workloadNames[w]);
+    fillScript(w);
+
+    begin(&m, names[0]);
+    for (i = 0; i < ITERATIONS; i++) {
+        sim->pen = script[i];
+        if (twlcdcTouchPenDown() && twlcdcTouchRead(&pos)) {
+            m.samples++;
+        }
+    }
+    end(&m, ITERATIONS, limitReadNs);
+
+    begin(&m, names[1]);
+    for (i = 0; i < ITERATIONS; i++) {
+        sim->pen = script[i];
+        if (twlcdcTouchPoll(&pos, TWLCDC_POLL_CHECKED)) {
+            m.samples++;
+        }
+    }
+    end(&m, ITERATIONS, limitReadNs);
+
+    begin(&m, names[2]);
+    for (i = 0; i < ITERATIONS; i++) {
+        sim->pen = script[i];
+        if (twlcdcTouchPoll(&pos, TWLCDC_POLL_FAST)) {
+            m.samples++;
+        }
+    }
+    end(&m, ITERATIONS, limitReadNs);
+}
+
+static int usage(void) {
+    fprintf(stderr, "usage: bench_workloads [-l latency_us] [-r read_ns] [-i init_ns] [-c calibration_ns] [baseline]\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    static simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchCalibration calibration;
+    twlcdcTouchPosition pos;
+    measurement m;
+    const char *env = getenv("TWLCDC_BENCH_LATENCY_US");
+    int w, opt;
+    u32 i;
+
+    if (env != NULL && *env != '\0') {
+        latencyUs = strtoul(env, NULL, 0);
+    }
+    while ((opt = getopt(argc, argv, "l:r:i:c:")) != -1) {
+        switch (opt) {
+        case 'l':
+            latencyUs = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            limitReadNs = strtod(optarg, NULL);
+            break;
+        case 'i':
+            limitInitNs = strtod(optarg, NULL);
+            break;
+        case 'c':
+            limitCalibrationNs = strtod(optarg, NULL);
+            break;
+        default:
+            return usage();
+        }
+    }
+    if (optind < argc) {
+        if (optind + 1 != argc || strcmp(argv[optind], "baseline")) {
+            return usage();
+        }
+        printBaseline = true;
+    }
+    if (printBaseline && latencyUs != BASELINE_LATENCY_US) {
+        fprintf(stderr, "the baseline is for a latency of %u us\n", BASELINE_LATENCY_US);
+        return 2;
+    }
+    loadBaseline();
+    if (!printBaseline) {
+        printf("# register access latency: %lu us\n", latencyUs);
+    }
+
+    hostReset();
+    simTscInit(&sim);
+    sim.latencyTicks = latencyUs * HOST_TICKS_PER_US;
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+
+    // init/exit; twlcdcInit() also reads the calibration from the config service
+    begin(&m, "init_exit");
+    for (i = 0; i < INIT_ITERATIONS; i++) {
+        twlcdcInit();
+        twlcdcExit();
+    }
+    end(&m, INIT_ITERATIONS, limitInitNs);
+    reportBaseline("init_exit", "cfg_calls_per_op", (double) hostCfgCalls / INIT_ITERATIONS);
+    // every controller access goes through the backend
+    if (hostCdcChkCalls != 0 || hostCdcChk2Calls != 0) {
+        fprintf(stderr, "init_exit: %u cdc:CHK calls bypassed the backend\n", hostCdcChkCalls + hostCdcChk2Calls);
+        benchFailures++;
+    }
+
+    if (!twlcdcInit()) {
+        fprintf(stderr, "init failed\n");
+        return 1;
+    }
+
+    // suspend and restore, as on a HOME menu round trip
+    begin(&m, "suspend_resume");
+    for (i = 0; i < INIT_ITERATIONS; i++) {
+        hostAptSignal(APTHOOK_ONSUSPEND);
+        hostAptSignal(APTHOOK_ONRESTORE);
+    }
+    end(&m, INIT_ITERATIONS, limitInitNs);
+
+    // sleep and wake; the controller keeps its configuration
+    begin(&m, "sleep_wake");
+    for (i = 0; i < INIT_ITERATIONS; i++) {
+        hostAptSignal(APTHOOK_ONSLEEP);
+        hostAptSignal(APTHOOK_ONWAKEUP);
+    }
+    end(&m, INIT_ITERATIONS, limitInitNs);
+
+    fillScript(WORKLOAD_DRAWING);
+    begin(&m, "read");
+    for (i = 0; i < ITERATIONS; i++) {
+        sim.pen = script[i];
+        if (twlcdcTouchRead(&pos)) {
+            m.samples++;
+        }
+    }
+    end(&m, ITERATIONS, limitReadNs);
+
+    twlcdcTouchCopyCalibration(&calibration);
+    begin(&m, "set_calibration");
+    for (i = 0; i < ITERATIONS; i++) {
+        twlcdcTouchSetCalibration(&calibration);
+    }
+    end(&m, ITERATIONS, limitCalibrationNs);
+
+    for (w = 0; w < WORKLOAD_COUNT; w++) {
+        benchWorkload(&sim, w);
+    }
+
+    twlcdcExit();
+    twlcdcSetBackend(NULL);
+    return BENCH_RESULT();
+}
@@ -0,0 +1,130 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host test support - minimal libctru stand-in
+
+    Only the subset of libctru used by libtwlcdc is provided. Services are
+    backed by host/ctru.c: threads and locks map to pthreads, the system
+    tick is a fake clock under test control, and cfg:u/APT/hid return
+    values set by the tests.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_HOST_3DS_H__
+#define __LIBTWLCDC_HOST_3DS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef s32 Result;
+typedef u32 Handle;
+
+#define BIT(n) (1U<<(n))
+#define R_SUCCEEDED(res) ((res)>=0)
+#define R_FAILED(res) ((res)<0)
+#define U64_MAX UINT64_MAX
+#define CUR_THREAD_HANDLE 0xFFFF8000
+
+#define SYSCLOCK_ARM11 268111856
+#define GSP_SCREEN_WIDTH 240
+#define GSP_SCREEN_HEIGHT_BOTTOM 320
+
+#define KEY_A      BIT(0)
+#define KEY_SELECT BIT(2)
+#define KEY_START  BIT(3)
+#define KEY_TOUCH  BIT(20)
+
+// services
+Result CDCCHK_ReadRegisters1(u8 pageID, u8 registerID, void *data, size_t size);
+Result CDCCHK_WriteRegisters1(u8 pageID, u8 registerID, const void *data, size_t size);
+Result CDCCHK_ReadRegisters2(u8 pageID, u8 registerID, void *data, size_t size);
+Result CDCCHK_WriteRegisters2(u8 pageID, u8 registerID, const void *data, size_t size);
+Result CFG_GetConfigInfoBlk4(u32 size, u32 blkID, void *outData);
+
+typedef enum {
+    APTHOOK_ONSUSPEND = 0,
+    APTHOOK_ONRESTORE,
+    APTHOOK_ONSLEEP,
+    APTHOOK_ONWAKEUP,
+    APTHOOK_ONEXIT,
+} APT_HookType;
+
+typedef void (*aptHookFn)(APT_HookType hook, void *param);
+
+typedef struct aptHookCookie {
+    struct aptHookCookie *next;
+    aptHookFn callback;
+    void *param;
+} aptHookCookie;
+
+void aptHook(aptHookCookie *cookie, aptHookFn callback, void *param);
+void aptUnhook(aptHookCookie *cookie);
+
+typedef struct {
+    u16 px;
+    u16 py;
+} touchPosition;
+
+void hidScanInput(void);
+u32 hidKeysHeld(void);
+u32 hidKeysDown(void);
+u32 hidKeysUp(void);
+void hidTouchRead(touchPosition *pos);
+
+// kernel
+u64 svcGetSystemTick(void);
+void svcSleepThread(s64 ns);
+Result svcGetThreadPriority(s32 *out, Handle handle);
+
+typedef struct Thread_tag *Thread;
+typedef void (*ThreadFunc)(void *);
+
+Thread threadCreate(ThreadFunc entrypoint, void *arg, size_t stack_size, int prio, int core_id, bool detached);
+Result threadJoin(Thread thread, u64 timeout_ns);
+void threadFree(Thread thread);
+
+// Zero-initialized locks are valid, as in libctru.
+typedef pthread_mutex_t LightLock;
+
+typedef struct {
+    LightLock lock;
+    pthread_t owner;
+    bool owned;
+    u32 counter;
+} RecursiveLock;
+
+typedef enum {
+    RESET_ONESHOT = 0,
+    RESET_STICKY = 1,
+    RESET_PULSE = 2,
+} ResetType;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool signaled;
+    ResetType type;
+} LightEvent;
+
+void LightLock_Init(LightLock *lock);
+void LightLock_Lock(LightLock *lock);
+void LightLock_Unlock(LightLock *lock);
+void RecursiveLock_Init(RecursiveLock *lock);
+void RecursiveLock_Lock(RecursiveLock *lock);
+void RecursiveLock_Unlock(RecursiveLock *lock);
+void LightEvent_Init(LightEvent *event, ResetType reset_type);
+void LightEvent_Clear(LightEvent *event);
+void LightEvent_Signal(LightEvent *event);
+void LightEvent_Wait(LightEvent *event);
+int LightEvent_WaitTimeout(LightEvent *event, s64 timeout_ns);
+
+#endif /* __LIBTWLCDC_HOST_3DS_H__ */
@@ -0,0 +1,275 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host test support - libctru stand-in implementation
+
+---------------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <3ds.h>
+#include "host.h"
+
+static const s16 hostDefaultCalibration[8] = { 0x2A0, 0x3C0, 32, 24, 0xD40, 0xC20, 288, 216 };
+
+s16 hostCalibration[8];
+u32 hostCfgCalls;
+u32 hostCdcChkCalls;
+u32 hostCdcChk2Calls;
+
+static u64 hostTick;
+static aptHookCookie *hostAptHooks;
+static u32 hostKeys, hostKeysPrev, hostKeysNext;
+
+void hostReset(void) {
+    memcpy(hostCalibration, hostDefaultCalibration, sizeof(hostCalibration));
+    hostCfgCalls = 0;
+    hostCdcChkCalls = 0;
+    hostCdcChk2Calls = 0;
+    hostKeys = hostKeysPrev = hostKeysNext = 0;
+    __atomic_store_n(&hostTick, 0, __ATOMIC_RELAXED);
+}
+
+void hostSetTick(u64 tick) {
+    __atomic_store_n(&hostTick, tick, __ATOMIC_RELAXED);
+}
+
+void hostAdvance(u64 ticks) {
+    __atomic_add_fetch(&hostTick, ticks, __ATOMIC_RELAXED);
+}
+
+// services
+
+Result CDCCHK_ReadRegisters1(u8 pageID, u8 registerID, void *data, size_t size) {
+    hostCdcChkCalls++;
+    memset(data, 0, size);
+    return -1;
+}
+
+Result CDCCHK_WriteRegisters1(u8 pageID, u8 registerID, const void *data, size_t size) {
+    hostCdcChkCalls++;
+    return -1;
+}
+
+// CTR-mode codec registers; the read mode toggle is the only user.
+static u8 hostCtrRegs[256][128];
+
+Result CDCCHK_ReadRegisters2(u8 pageID, u8 registerID, void *data, size_t size) {
+    hostCdcChk2Calls++;
+    memcpy(data, &hostCtrRegs[pageID][registerID], size);
+    return 0;
+}
+
+Result CDCCHK_WriteRegisters2(u8 pageID, u8 registerID, const void *data, size_t size) {
+    hostCdcChk2Calls++;
+    memcpy(&hostCtrRegs[pageID][registerID], data, size);
+    return 0;
+}
+
+Result CFG_GetConfigInfoBlk4(u32 size, u32 blkID, void *outData) {
+    hostCfgCalls++;
+    if (blkID != 0x00040000 || size > sizeof(hostCalibration)) {
+        return -1;
+    }
+    memcpy(outData, hostCalibration, size);
+    return 0;
+}
+
+void aptHook(aptHookCookie *cookie, aptHookFn callback, void *param) {
+    cookie->callback = callback;
+    cookie->param = param;
+    cookie->next = hostAptHooks;
+    hostAptHooks = cookie;
+}
+
+void aptUnhook(aptHookCookie *cookie) {
+    aptHookCookie **p;
+    for (p = &hostAptHooks; *p != NULL; p = &(*p)->next) {
+        if (*p == cookie) {
+            *p = cookie->next;
+            break;
+        }
+    }
+}
+
+void hostAptSignal(APT_HookType type) {
+    aptHookCookie *cookie;
+    for (cookie = hostAptHooks; cookie != NULL; cookie = cookie->next) {
+        cookie->callback(type, cookie->param);
+    }
+}
+
+void hostSetKeys(u32 held) {
+    hostKeysNext = held;
+}
+
+void hidScanInput(void) {
+    hostKeysPrev = hostKeys;
+    hostKeys = hostKeysNext;
+}
+
+u32 hidKeysHeld(void) {
+    return hostKeys;
+}
+
+u32 hidKeysDown(void) {
+    return hostKeys & ~hostKeysPrev;
+}
+
+u32 hidKeysUp(void) {
+    return ~hostKeys & hostKeysPrev;
+}
+
+void hidTouchRead(touchPosition *pos) {
+    pos->px = 0;
+    pos->py = 0;
+}
+
+// kernel
+
+u64 svcGetSystemTick(void) {
+    return __atomic_load_n(&hostTick, __ATOMIC_RELAXED);
+}
+
+void svcSleepThread(s64 ns) {
+    // Time passes while sleeping; the host thread only yields.
+    if (ns > 0) {
+        hostAdvance((u64) ns * SYSCLOCK_ARM11 / 1000000000);
+    }
+    sched_yield();
+}
+
+Result svcGetThreadPriority(s32 *out, Handle handle) {
+    *out = 0x30;
+    return 0;
+}
+
+struct Thread_tag {
+    pthread_t thread;
+    ThreadFunc entrypoint;
+    void *arg;
+};
+
+static void *hostThreadMain(void *arg) {
+    struct Thread_tag *thread = arg;
+    thread->entrypoint(thread->arg);
+    return NULL;
+}
+
+Thread threadCreate(ThreadFunc entrypoint, void *arg, size_t stack_size, int prio, int core_id, bool detached) {
+    struct Thread_tag *thread = malloc(sizeof(*thread));
+
+    if (thread == NULL) {
+        return NULL;
+    }
+    thread->entrypoint = entrypoint;
+    thread->arg = arg;
+    if (pthread_create(&thread->thread, NULL, hostThreadMain, thread) != 0) {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+Result threadJoin(Thread thread, u64 timeout_ns) {
+    pthread_join(thread->thread, NULL);
+    return 0;
+}
+
+void threadFree(Thread thread) {
+    free(thread);
+}
+
+void LightLock_Init(LightLock *lock) {
+    pthread_mutex_init(lock, NULL);
+}
+
+void LightLock_Lock(LightLock *lock) {
+    pthread_mutex_lock(lock);
+}
+
+void LightLock_Unlock(LightLock *lock) {
+    pthread_mutex_unlock(lock);
+}
+
+void RecursiveLock_Init(RecursiveLock *lock) {
+    memset(lock, 0, sizeof(*lock));
+    LightLock_Init(&lock->lock);
+}
+
+void RecursiveLock_Lock(RecursiveLock *lock) {
+    if (__atomic_load_n(&lock->owned, __ATOMIC_ACQUIRE) && pthread_equal(lock->owner, pthread_self())) {
+        lock->counter++;
+        return;
+    }
+    LightLock_Lock(&lock->lock);
+    lock->owner = pthread_self();
+    __atomic_store_n(&lock->owned, true, __ATOMIC_RELEASE);
+    lock->counter = 1;
+}
+
+void RecursiveLock_Unlock(RecursiveLock *lock) {
+    if (--lock->counter == 0) {
+        __atomic_store_n(&lock->owned, false, __ATOMIC_RELEASE);
+        LightLock_Unlock(&lock->lock);
+    }
+}
+
+void LightEvent_Init(LightEvent *event, ResetType reset_type) {
+    pthread_mutex_init(&event->mutex, NULL);
+    pthread_cond_init(&event->cond, NULL);
+    event->signaled = false;
+    event->type = reset_type;
+}
+
+void LightEvent_Clear(LightEvent *event) {
+    pthread_mutex_lock(&event->mutex);
+    event->signaled = false;
+    pthread_mutex_unlock(&event->mutex);
+}
+
+void LightEvent_Signal(LightEvent *event) {
+    pthread_mutex_lock(&event->mutex);
+    event->signaled = true;
+    pthread_cond_broadcast(&event->cond);
+    pthread_mutex_unlock(&event->mutex);
+}
+
+static int hostEventWait(LightEvent *event, const struct timespec *deadline) {
+    int result = 0;
+
+    pthread_mutex_lock(&event->mutex);
+    while (!event->signaled && result != ETIMEDOUT) {
+        result = deadline != NULL
+            ? pthread_cond_timedwait(&event->cond, &event->mutex, deadline)
+            : pthread_cond_wait(&event->cond, &event->mutex);
+    }
+    if (event->signaled) {
+        if (event->type != RESET_STICKY) {
+            event->signaled = false;
+        }
+        result = 0;
+    }
+    pthread_mutex_unlock(&event->mutex);
+    return result == ETIMEDOUT;
+}
+
+void LightEvent_Wait(LightEvent *event) {
+    hostEventWait(event, NULL);
+}
+
+// Returns 1 on timeout, as libctru does. The timeout is real time.
+int LightEvent_WaitTimeout(LightEvent *event, s64 timeout_ns) {
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ns / 1000000000;
+    deadline.tv_nsec += timeout_ns % 1000000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    return hostEventWait(event, &deadline);
+}
@@ -0,0 +1,37 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host test support - controls for the libctru stand-in
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_HOST_H__
+#define __LIBTWLCDC_HOST_H__
+
+#include <3ds.h>
+
+// touch calibration returned by CFG_GetConfigInfoBlk4(0x00040000)
+extern s16 hostCalibration[8];
+
+// service call counters; the cdc:CHK stand-ins fail, so that register
+// accesses bypassing the library's backend are caught
+extern u32 hostCfgCalls;
+extern u32 hostCdcChkCalls;
+extern u32 hostCdcChk2Calls;
+
+// Restore the initial state: tick 0, default calibration, counters cleared.
+void hostReset(void);
+
+// The system tick only advances when told to, or by svcSleepThread().
+void hostSetTick(u64 tick);
+void hostAdvance(u64 ticks);
+
+#define HOST_TICKS_PER_MS (SYSCLOCK_ARM11 / 1000)
+#define HOST_TICKS_PER_US (SYSCLOCK_ARM11 / 1000000)
+
+// Run the registered APT hooks, as on a HOME menu suspend/restore.
+void hostAptSignal(APT_HookType type);
+
+// Button state reported by the hid stand-in after the next hidScanInput().
+void hostSetKeys(u32 held);
+
+#endif /* __LIBTWLCDC_HOST_H__ */
@@ -0,0 +1,169 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tool - replay a touch capture
+
+    Maps a capture made with twlcdcCaptureStart() and reads it back through
+    the library at full speed, with the given filter, smoothing and saved
+    settings. Reports the replay rate and a digest of every position read,
+    so that captures can be compared across library versions and settings.
+
+    usage: replay_tool [options] capture.twlt
+      -f mean|median|trimmed|spread   averaging filter (default: mean)
+      -m spread                       largest spread for the spread filter
+      -s                              enable position smoothing
+      -p settings.bin                 load settings saved by twlcdcSettingsSaveFile()
+      -n rounds                       replay the capture this many times (default: 1)
+
+---------------------------------------------------------------------------------*/
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "bench.h"
+
+static const twlcdcSmootherConfig smoothing = { .minCutoff = 1 << 8, .beta = 6554 };
+
+static const char *filterNames[] = { "mean", "median", "trimmed", "spread" };
+
+// FNV-1a, over everything a position read reports
+static u64 digestAdd(u64 digest, const void *data, size_t size) {
+    const u8 *bytes = data;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        digest = (digest ^ bytes[i]) * 0x100000001B3ull;
+    }
+    return digest;
+}
+
+static int usage(void) {
+    fprintf(stderr, "usage: replay_tool [-f mean|median|trimmed|spread] [-m spread] [-s] [-p settings.bin] [-n rounds] capture.twlt\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    twlcdcReplay replay;
+    twlcdcBackend backend;
+    twlcdcTouchPositionEx pos;
+    twlcdcFilter filter = TWLCDC_FILTER_MEAN;
+    u16 maxSpread = 0;
+    bool smooth = false;
+    const char *settingsPath = NULL;
+    long rounds = 1, round;
+    u64 digest = 0xCBF29CE484222325ull, samples = 0, records = 0;
+    struct stat st;
+    double start, elapsed;
+    void *data;
+    int fd, opt;
+    size_t i;
+
+    while ((opt = getopt(argc, argv, "f:m:sp:n:")) != -1) {
+        switch (opt) {
+        case 'f':
+            for (i = 0; i < sizeof(filterNames) / sizeof(filterNames[0]); i++) {
+                if (!strcmp(optarg, filterNames[i])) break;
+            }
+            if (i == sizeof(filterNames) / sizeof(filterNames[0])) {
+                return usage();
+            }
+            filter = i;
+            break;
+        case 'm':
+            maxSpread = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            smooth = true;
+            break;
+        case 'p':
+            settingsPath = optarg;
+            break;
+        case 'n':
+            rounds = strtol(optarg, NULL, 0);
+            if (rounds < 1) {
+                return usage();
+            }
+            break;
+        default:
+            return usage();
+        }
+    }
+    if (optind + 1 != argc) {
+        return usage();
+    }
+
+    fd = open(argv[optind], O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (!twlcdcReplayInit(&replay, data, st.st_size)) {
+        fprintf(stderr, "%s: not a supported capture\n", argv[optind]);
+        return 1;
+    }
+
+    hostReset();
+    if (settingsPath != NULL) {
+        FILE *file = fopen(settingsPath, "rb");
+        if (file == NULL || !twlcdcSettingsLoadFile(file)) {
+            fprintf(stderr, "%s: could not load settings\n", settingsPath);
+            return 1;
+        }
+        fclose(file);
+    } else {
+        twlcdcTouchSetFilter(filter, maxSpread);
+    }
+
+    memset(&backend, 0, sizeof(backend));
+    twlcdcReplayBackend(&replay, &backend);
+    twlcdcSetBackend(&backend);
+    if (!twlcdcInit()) {
+        fprintf(stderr, "init failed\n");
+        return 1;
+    }
+
+    start = benchNow();
+    for (round = 0; round < rounds; round++) {
+        // every round starts from the same state
+        twlcdcReplayInit(&replay, data, st.st_size);
+        twlcdcTouchSetSmoothing(smooth ? &smoothing : NULL);
+        while (replay.position < replay.count) {
+            bool down = twlcdcTouchReadEx(&pos);
+            records++;
+            // only the first round goes into the digest; the rest are timing
+            if (round == 0) {
+                digest = digestAdd(digest, &down, sizeof(down));
+                if (down) {
+                    digest = digestAdd(digest, &pos.pos.px, sizeof(pos.pos.px));
+                    digest = digestAdd(digest, &pos.pos.py, sizeof(pos.pos.py));
+                    digest = digestAdd(digest, &pos.fx, sizeof(pos.fx));
+                    digest = digestAdd(digest, &pos.fy, sizeof(pos.fy));
+                    digest = digestAdd(digest, &pos.pressure, sizeof(pos.pressure));
+                }
+            }
+            samples += down;
+        }
+    }
+    elapsed = benchNow() - start;
+
+    twlcdcExit();
+    twlcdcSetBackend(NULL);
+    munmap(data, st.st_size);
+    close(fd);
+
+    printf("replay,records,%llu\n", (unsigned long long) records / rounds);
+    printf("replay,samples,%llu\n", (unsigned long long) samples / rounds);
+    benchReport("replay", "samples_per_s", elapsed > 0 ? samples * 1e9 / elapsed : 0, 0);
+    benchReport("replay", "ns_per_record", records > 0 ? elapsed / records : 0, 0);
+    printf("replay,digest,%016llx\n", (unsigned long long) digest);
+    return 0;
+}
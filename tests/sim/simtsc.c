@@ -0,0 +1,187 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host test support - simulated touch screen controller
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include <3ds.h>
+#include "host.h"
+#include "simtsc.h"
+
+void simTscInit(simTsc *sim) {
+    memset(sim, 0, sizeof(simTsc));
+    sim->seed = 1;
+    // power-on values of the registers the library touches
+    sim->touchcnt[0x02] = 0x18;
+    sim->touchcnt[0x03] = 0x87;
+    sim->touchcnt[0x04] = 0x22;
+    sim->touchcnt[0x05] = 0x04;
+    sim->touchcnt[0x0E] = 0x00;
+    sim->touchcnt[0x0F] = 0x00;
+    sim->touchcnt[0x12] = 0x00;
+    // handed to the CTR-mode codec, as the system leaves it
+    sim->ctr[0x25] = 0x40;
+}
+
+void simTscSetPen(simTsc *sim, bool down, u16 rawx, u16 rawy, u16 z1, u16 z2) {
+    sim->pen.down = down;
+    sim->pen.rawx = rawx;
+    sim->pen.rawy = rawy;
+    sim->pen.z1 = z1;
+    sim->pen.z2 = z2;
+}
+
+void simTscScript(simTsc *sim, const simPen *script, size_t count) {
+    sim->script = script;
+    sim->scriptCount = count;
+    sim->scriptPosition = 0;
+    if (count > 0) {
+        sim->pen = script[0];
+    }
+}
+
+void simTscClearCounters(simTsc *sim) {
+    memset(sim->reads, 0, sizeof(sim->reads));
+    memset(sim->writes, 0, sizeof(sim->writes));
+    sim->logCount = 0;
+}
+
+u32 simTscAccesses(const simTsc *sim) {
+    u32 total = 0;
+    int i;
+    for (i = 0; i < 256; i++) {
+        total += sim->reads[i] + sim->writes[i];
+    }
+    return total;
+}
+
+void simTscEncode(const simPen *pen, u8 *raw) {
+    int i;
+
+    if (!pen->down) {
+        // conversions with the pen up carry the invalid flag bits
+        memset(raw, 0xFF, 40);
+        return;
+    }
+    for (i = 0; i < 5; i++) {
+        u16 values[4] = { pen->rawx, pen->rawy, pen->z1, pen->z2 };
+        int j;
+        for (j = 0; j < 4; j++) {
+            raw[j*10 + i*2]     = values[j] >> 8;
+            raw[j*10 + i*2 + 1] = values[j];
+        }
+    }
+}
+
+static u16 simNoise(simTsc *sim, u16 value) {
+    s32 offset;
+
+    if (sim->noise == 0) {
+        return value;
+    }
+    sim->seed = sim->seed * 1103515245 + 12345;
+    offset = (s32) ((sim->seed >> 16) % (sim->noise + 1)) - sim->noise / 2;
+    offset += value;
+    return offset < 0 ? 0 : (offset > 0xFFF ? 0xFFF : offset);
+}
+
+static void simFillData(simTsc *sim, u8 *raw) {
+    int i;
+
+    simTscEncode(&sim->pen, raw);
+    if (sim->pen.down && sim->noise != 0) {
+        for (i = 0; i < 10; i++) {
+            u16 value = simNoise(sim, (raw[i*2] << 8) | raw[i*2 + 1]);
+            raw[i*2] = value >> 8;
+            raw[i*2 + 1] = value;
+        }
+    }
+    if (sim->pen.down && sim->glitch != 0) {
+        for (i = 0; i < 10; i += 5) {
+            s32 value = ((raw[i*2] << 8) | raw[i*2 + 1]) + sim->glitch;
+            value = value < 0 ? 0 : (value > 0xFFF ? 0xFFF : value);
+            raw[i*2] = value >> 8;
+            raw[i*2 + 1] = value;
+        }
+    }
+
+    if (sim->script != NULL && sim->scriptPosition + 1 < sim->scriptCount) {
+        sim->pen = sim->script[++sim->scriptPosition];
+    }
+}
+
+static Result simRead(void *userdata, u8 bank, u8 reg, void *data, size_t size) {
+    simTsc *sim = userdata;
+
+    hostAdvance(sim->latencyTicks);
+    sim->reads[bank]++;
+    if (bank == SIM_BANK_TOUCHDATA) {
+        u8 raw[128];
+        memset(raw, 0xFF, sizeof(raw));
+        simFillData(sim, raw);
+        memcpy(data, raw, size);
+    } else if (bank == SIM_BANK_TOUCHCNT && reg + size <= sizeof(sim->touchcnt)) {
+        // pen status: 0x09 bits 6-7 read 01 while the pen is up
+        sim->touchcnt[0x09] = sim->pen.down ? 0x00 : 0x40;
+        memcpy(data, sim->touchcnt + reg, size);
+    } else {
+        memset(data, 0, size);
+        return -1;
+    }
+    return 0;
+}
+
+static Result simWrite(void *userdata, u8 bank, u8 reg, const void *data, size_t size) {
+    simTsc *sim = userdata;
+
+    hostAdvance(sim->latencyTicks);
+    sim->writes[bank]++;
+    if (sim->logCount < SIM_LOG_SIZE) {
+        simWriteRecord *record = &sim->log[sim->logCount];
+        record->bank = bank;
+        record->reg = reg;
+        record->size = size;
+        memcpy(record->data, data, size < sizeof(record->data) ? size : sizeof(record->data));
+    }
+    sim->logCount++;
+    if (bank == SIM_BANK_TOUCHCNT && reg + size <= sizeof(sim->touchcnt)) {
+        memcpy(sim->touchcnt + reg, data, size);
+        return 0;
+    }
+    return -1;
+}
+
+static Result simReadCtr(void *userdata, u8 page, u8 reg, void *data, size_t size) {
+    simTsc *sim = userdata;
+
+    hostAdvance(sim->latencyTicks);
+    sim->reads[page]++;
+    if (page != SIM_CTR_PAGE || reg + size > sizeof(sim->ctr)) {
+        memset(data, 0, size);
+        return -1;
+    }
+    memcpy(data, sim->ctr + reg, size);
+    return 0;
+}
+
+static Result simWriteCtr(void *userdata, u8 page, u8 reg, const void *data, size_t size) {
+    simTsc *sim = userdata;
+
+    hostAdvance(sim->latencyTicks);
+    sim->writes[page]++;
+    if (page != SIM_CTR_PAGE || reg + size > sizeof(sim->ctr)) {
+        return -1;
+    }
+    memcpy(sim->ctr + reg, data, size);
+    return 0;
+}
+
+void simTscBackend(simTsc *sim, twlcdcBackend *backend) {
+    memset(backend, 0, sizeof(twlcdcBackend));
+    backend->readRegisters = simRead;
+    backend->writeRegisters = simWrite;
+    backend->readCtrRegisters = simReadCtr;
+    backend->writeCtrRegisters = simWriteCtr;
+    backend->userdata = sim;
+}
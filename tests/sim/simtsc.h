@@ -0,0 +1,71 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host test support - simulated touch screen controller
+
+    Models the CDC_TOUCHCNT (0x03) register bank and the CTR-mode codec
+    page holding the TSC read mode (0x67) as plain memory, and the
+    CDC_TOUCHDATA (0xFC) buffer as five X/Y/Z1/Z2 conversions of the
+    current pen state, optionally with noise. A scripted pen trace can be
+    played back, one step per data buffer read. Every access is counted
+    and advances the host clock by a configurable bus latency.
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_SIMTSC_H__
+#define __LIBTWLCDC_SIMTSC_H__
+
+#include <stdbool.h>
+#include <3ds.h>
+#include "twlcdc.h"
+
+#define SIM_BANK_TOUCHCNT  0x03
+#define SIM_BANK_TOUCHDATA 0xFC
+#define SIM_CTR_PAGE       0x67
+
+typedef struct simPen {
+    bool down;
+    u16 rawx;
+    u16 rawy;
+    u16 z1;
+    u16 z2;
+} simPen;
+
+#define SIM_LOG_SIZE 64
+
+// One register write, as seen by the controller.
+typedef struct simWriteRecord {
+    u8 bank;
+    u8 reg;
+    u8 size;
+    u8 data[8];
+} simWriteRecord;
+
+typedef struct simTsc {
+    u8 touchcnt[128];
+    u8 ctr[128];        // CTR-mode codec page 0x67; 0x25 bit 6 is the read mode
+    simPen pen;
+    u16 noise;          // peak-to-peak raw noise added to each conversion
+    s16 glitch;         // offset added to the first X and Y conversion, as
+                        // when the pen is still settling on touch-down
+    u32 seed;
+    const simPen *script;
+    size_t scriptCount;
+    size_t scriptPosition;
+    u64 latencyTicks;   // host clock advance per register access
+    u32 reads[256];     // register accesses, per bank or CTR page
+    u32 writes[256];
+    simWriteRecord log[SIM_LOG_SIZE]; // the first TSC writes since the counters were cleared
+    size_t logCount;
+} simTsc;
+
+void simTscInit(simTsc *sim);
+void simTscBackend(simTsc *sim, twlcdcBackend *backend);
+void simTscSetPen(simTsc *sim, bool down, u16 rawx, u16 rawy, u16 z1, u16 z2);
+// Play back a pen trace, one step per data buffer read; the last step is held.
+void simTscScript(simTsc *sim, const simPen *script, size_t count);
+void simTscClearCounters(simTsc *sim);
+u32 simTscAccesses(const simTsc *sim);
+// Fill a 40-byte data buffer from a pen state, as the controller would.
+void simTscEncode(const simPen *pen, u8 *raw);
+
+#endif /* __LIBTWLCDC_SIMTSC_H__ */
@@ -0,0 +1,32 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - minimal assertion helpers
+
+---------------------------------------------------------------------------------*/
+
+#ifndef __LIBTWLCDC_TEST_H__
+#define __LIBTWLCDC_TEST_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int testFailures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        testFailures++; \
+    } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long _a = (long long) (a), _b = (long long) (b); \
+    if (_a != _b) { \
+        fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+        testFailures++; \
+    } \
+} while (0)
+
+#define TEST_RESULT() (testFailures == 0 ? (printf("%s: ok\n", __FILE__), 0) : (printf("%s: %d failure(s)\n", __FILE__, testFailures), 1))
+
+#endif /* __LIBTWLCDC_TEST_H__ */
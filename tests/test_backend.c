@@ -0,0 +1,92 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - simulated controller backend
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchPosition pos;
+    u8 powerOn[128];
+    u64 tick;
+    int i;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    memcpy(powerOn, sim.touchcnt, sizeof(powerOn));
+    twlcdcSetBackend(&backend);
+
+    CHECK(twlcdcInit());
+    CHECK_EQ(hostCdcChkCalls, 0);
+    CHECK_EQ(hostCdcChk2Calls, 0);
+    CHECK_EQ(hostCfgCalls, 1);
+    // the TSC is taken over from the CTR-mode codec through the backend
+    CHECK_EQ(sim.ctr[0x25], 0x00);
+    CHECK_EQ(sim.reads[SIM_CTR_PAGE], 1);
+    CHECK_EQ(sim.writes[SIM_CTR_PAGE], 1);
+    // default conversion settings
+    CHECK_EQ(sim.touchcnt[0x03], 0x8B);
+    CHECK_EQ(sim.touchcnt[0x0F], 0xA0);
+    CHECK(sim.reads[SIM_BANK_TOUCHCNT] > 0);
+    CHECK(sim.writes[SIM_BANK_TOUCHCNT] > 0);
+
+    // pen up: the data buffer is invalid
+    CHECK(!twlcdcTouchPenDown());
+    CHECK(!twlcdcTouchRead(&pos));
+
+    // pen down at raw 0x800/0x700, with noise; the default calibration
+    // maps 0x2A0..0xD40 to 32..288 and 0x3C0..0xC20 to 24..216
+    sim.noise = 8;
+    simTscSetPen(&sim, true, 0x800, 0x700, 0x180, 0x900);
+    CHECK(twlcdcTouchPenDown());
+    for (i = 0; i < 100; i++) {
+        CHECK(twlcdcTouchRead(&pos));
+        CHECK(pos.px >= 160 && pos.px <= 163);
+        CHECK(pos.py >= 98 && pos.py <= 101);
+    }
+
+    // scripted trace, one step per data read
+    {
+        static const simPen trace[] = {
+            { true, 0x2A0, 0x3C0, 0x180, 0x900 },
+            { true, 0xD40, 0xC20, 0x180, 0x900 },
+            { false, 0, 0, 0, 0 },
+        };
+        sim.noise = 0;
+        simTscScript(&sim, trace, 3);
+        CHECK(twlcdcTouchRead(&pos));
+        CHECK_EQ(pos.px, 32);
+        CHECK_EQ(pos.py, 24);
+        CHECK(twlcdcTouchRead(&pos));
+        CHECK_EQ(pos.px, 288);
+        CHECK_EQ(pos.py, 216);
+        CHECK(!twlcdcTouchRead(&pos));
+    }
+
+    // bus latency is charged to the host clock
+    sim.latencyTicks = 100 * HOST_TICKS_PER_US;
+    simTscClearCounters(&sim);
+    tick = svcGetSystemTick();
+    twlcdcTouchRead(&pos);
+    CHECK_EQ(simTscAccesses(&sim), 1);
+    CHECK_EQ(svcGetSystemTick() - tick, 100 * HOST_TICKS_PER_US);
+    sim.latencyTicks = 0;
+
+    // exit restores the power-on register values
+    twlcdcExit();
+    CHECK(memcmp(sim.touchcnt + 0x02, powerOn + 0x02, 0x12 - 0x02 + 1) == 0);
+    CHECK_EQ(sim.ctr[0x25], 0x40);
+    CHECK_EQ(hostCdcChkCalls, 0);
+    CHECK_EQ(hostCdcChk2Calls, 0);
+
+    twlcdcSetBackend(NULL);
+    return TEST_RESULT();
+}
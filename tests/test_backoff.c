@@ -0,0 +1,59 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - idle polling backoff scheduler
+
+---------------------------------------------------------------------------------*/
+
+#include "backoff.h"
+#include "test.h"
+
+int main(void) {
+    twlcdcBackoff backoff;
+    uint64_t now = 0, polls = 0;
+    int i;
+
+    // doubles while idle, up to the maximum, and snaps back on contact
+    backoffInit(&backoff, 4, 100);
+    CHECK_EQ(backoffNext(&backoff, false), 8);
+    CHECK_EQ(backoffNext(&backoff, false), 16);
+    CHECK_EQ(backoffNext(&backoff, false), 32);
+    CHECK_EQ(backoffNext(&backoff, false), 64);
+    CHECK_EQ(backoffNext(&backoff, false), 100);
+    CHECK_EQ(backoffNext(&backoff, false), 100);
+    CHECK_EQ(backoffNext(&backoff, true), 4);
+    CHECK_EQ(backoffNext(&backoff, true), 4);
+    CHECK_EQ(backoffNext(&backoff, false), 8);
+
+    // degenerate limits
+    backoffInit(&backoff, 0, 0);
+    CHECK_EQ(backoffNext(&backoff, false), 1);
+    backoffInit(&backoff, 50, 10);
+    CHECK_EQ(backoffNext(&backoff, false), 50);
+    CHECK_EQ(backoffNext(&backoff, true), 50);
+
+    // no overflow near the top of the range
+    backoffInit(&backoff, 1, UINT64_MAX);
+    for (i = 0; i < 70; i++) {
+        uint64_t interval = backoffNext(&backoff, false);
+        CHECK(interval >= backoff.minInterval);
+    }
+    CHECK_EQ(backoff.interval, UINT64_MAX);
+
+    // one idle second, starting at 1 ms and backing off to 100 ms, on a
+    // fake clock: a handful of polls instead of a thousand
+    backoffInit(&backoff, 1000000, 100000000);
+    while (now < 1000000000) {
+        now += backoffNext(&backoff, false);
+        polls++;
+    }
+    CHECK(polls <= 16);
+
+    // contact every poll keeps the full rate
+    backoffInit(&backoff, 1000000, 100000000);
+    for (now = 0, polls = 0; now < 1000000000; polls++) {
+        now += backoffNext(&backoff, true);
+    }
+    CHECK_EQ(polls, 1000);
+
+    return TEST_RESULT();
+}
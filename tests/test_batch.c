@@ -0,0 +1,86 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - twlcdcTouchConvertBatch() against twlcdcTouchRead()
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define COUNT 2048
+
+static const twlcdcTouchCalibration calibration = {
+    0x1F0, 0x2E0, 32, 24, 0xE10, 0xD30, 288, 216
+};
+
+// a panel rotated by a few degrees, which needs the full affine transform
+static const twlcdcCalibrationPoint points[4] = {
+    { 0x240, 0x2A0, 32, 24 },
+    { 0xDF0, 0x330, 288, 24 },
+    { 0x1B0, 0xCD0, 32, 216 },
+    { 0xD60, 0xD60, 288, 216 },
+};
+
+static u32 seed = 1;
+
+static u16 random12(void) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0xFFF;
+}
+
+static void checkBatch(simTsc *sim) {
+    static twlcdcTouchPosition raw[COUNT], out[COUNT], inPlace[COUNT];
+    twlcdcTouchPosition pos;
+    u32 ipc;
+    int i;
+
+    for (i = 0; i < COUNT; i++) {
+        memset(&raw[i], 0, sizeof(raw[i]));
+        raw[i].rawx = random12();
+        raw[i].rawy = random12();
+        raw[i].z1 = 0x100 + i;
+        raw[i].z2 = 0x900 - i;
+    }
+
+    ipc = twlcdcGetIpcCount();
+    twlcdcTouchConvertBatch(raw, out, COUNT);
+    memcpy(inPlace, raw, sizeof(inPlace));
+    twlcdcTouchConvertBatch(inPlace, inPlace, COUNT);
+    CHECK_EQ(twlcdcGetIpcCount() - ipc, 0);
+
+    for (i = 0; i < COUNT; i++) {
+        simTscSetPen(sim, true, raw[i].rawx, raw[i].rawy, raw[i].z1, raw[i].z2);
+        CHECK(twlcdcTouchRead(&pos));
+        CHECK_EQ(out[i].px, pos.px);
+        CHECK_EQ(out[i].py, pos.py);
+        CHECK_EQ(out[i].rawx, raw[i].rawx);
+        CHECK_EQ(out[i].rawy, raw[i].rawy);
+        CHECK_EQ(out[i].z1, raw[i].z1);
+        CHECK_EQ(out[i].z2, raw[i].z2);
+        CHECK(!memcmp(&inPlace[i], &out[i], sizeof(out[i])));
+    }
+}
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    // the batch is bit-identical to reading each position, for two-point
+    // and affine calibrations alike
+    twlcdcTouchSetCalibration(&calibration);
+    checkBatch(&sim);
+    CHECK(twlcdcTouchSetCalibrationPoints(points, 4));
+    checkBatch(&sim);
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
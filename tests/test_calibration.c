@@ -0,0 +1,205 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - two-point and N-point calibration
+
+---------------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+static simTsc sim;
+
+static bool readAt(u16 rawx, u16 rawy, twlcdcTouchPositionEx *pos) {
+    simTscSetPen(&sim, true, rawx, rawy, 0x180, 0x900);
+    return twlcdcTouchReadEx(pos);
+}
+
+// Synthetic panel: screen position of the middle of an ADC step, given a
+// scale, rotation and shear relative to the nominal 3DS geometry.
+typedef struct {
+    double m[2][2];
+    double c[2];
+} panel;
+
+static void panelInit(panel *p, double rotation, double shear, double stretch) {
+    double sx = 256.0 / (0xD40 - 0x2A0), sy = 192.0 / (0xC20 - 0x3C0) * stretch;
+    double cr = cos(rotation), sr = sin(rotation);
+
+    p->m[0][0] = sx * cr;
+    p->m[0][1] = sy * (shear * cr - sr);
+    p->m[1][0] = sx * sr;
+    p->m[1][1] = sy * (shear * sr + cr);
+    // centre raw 0x800/0x7F0 on the middle of the screen
+    p->c[0] = 160 - p->m[0][0] * 0x800 - p->m[0][1] * 0x7F0;
+    p->c[1] = 120 - p->m[1][0] * 0x800 - p->m[1][1] * 0x7F0;
+}
+
+static double panelAxis(const panel *p, int axis, double rawx, double rawy) {
+    return p->m[axis][0] * (rawx + 0.5) + p->m[axis][1] * (rawy + 0.5) + p->c[axis];
+}
+
+// The raw reading when tapping a screen target, as a calibration tool would get it.
+static void panelTap(const panel *p, double x, double y, twlcdcCalibrationPoint *point) {
+    double det = p->m[0][0] * p->m[1][1] - p->m[0][1] * p->m[1][0];
+    double dx = x - p->c[0], dy = y - p->c[1];
+
+    point->rawx = floor((p->m[1][1] * dx - p->m[0][1] * dy) / det);
+    point->rawy = floor((p->m[0][0] * dy - p->m[1][0] * dx) / det);
+    point->px = x;
+    point->py = y;
+}
+
+// Largest error over the screen, in pixels.
+static double panelError(const panel *p) {
+    twlcdcTouchPositionEx pos;
+    double worst = 0;
+    int rawx, rawy;
+
+    for (rawx = 0; rawx < 0x1000; rawx += 13) {
+        for (rawy = 0; rawy < 0x1000; rawy += 13) {
+            double x = panelAxis(p, 0, rawx, rawy), y = panelAxis(p, 1, rawx, rawy);
+            if (x < 0 || x >= 320 || y < 0 || y >= 240) {
+                continue;
+            }
+            readAt(rawx, rawy, &pos);
+            x = fabs(pos.fx / 65536.0 - x);
+            y = fabs(pos.fy / 65536.0 - y);
+            worst = x > worst ? x : worst;
+            worst = y > worst ? y : worst;
+        }
+    }
+    return worst;
+}
+
+int main(void) {
+    static const twlcdcTouchCalibration nominal = {
+        0x2A0, 0x3C0, 32, 24, 0xD40, 0xC20, 288, 216
+    };
+    static const twlcdcCalibrationPoint corners[] = {
+        { 0x2A0, 0x3C0, 32, 24 }, { 0xD40, 0x3C0, 288, 24 },
+        { 0x2A0, 0xC20, 32, 216 }, { 0xD40, 0xC20, 288, 216 },
+    };
+    static s32 twoPoint[2][0x1000];
+    twlcdcBackend backend;
+    twlcdcTouchPositionEx pos;
+    twlcdcCalibrationPoint points[9];
+    int raw, i, mismatches;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    // degenerate input is refused
+    CHECK(!twlcdcTouchSetCalibrationPoints(corners, 2));
+    CHECK(!twlcdcTouchSetCalibrationPoints(points, 10));
+    for (i = 0; i < 3; i++) {
+        points[i].rawx = points[i].rawy = 0x400 * (i + 1);
+        points[i].px = points[i].py = 50 * i;
+    }
+    CHECK(!twlcdcTouchSetCalibrationPoints(points, 3));
+
+    // both accessors report what was set
+    twlcdcTouchSetCalibration(&nominal);
+    {
+        twlcdcTouchCalibration copy;
+        twlcdcTouchCopyCalibration(&copy);
+        CHECK(!memcmp(&copy, &nominal, sizeof(copy)));
+        CHECK(!memcmp(twlcdcTouchGetCalibration(), &nominal, sizeof(nominal)));
+    }
+
+    // both paths agree on the same geometry, for every raw value
+    for (raw = 0; raw < 0x1000; raw++) {
+        CHECK(readAt(raw, raw, &pos));
+        twoPoint[0][raw] = pos.fx;
+        twoPoint[1][raw] = pos.fy;
+    }
+    CHECK(twlcdcTouchSetCalibrationPoints(corners, 4));
+    mismatches = 0;
+    for (raw = 0; raw < 0x1000; raw++) {
+        CHECK(readAt(raw, raw, &pos));
+        // the two-point scale is truncated, the least-squares one rounded;
+        // over the full ADC range that amounts to well under 1/100 px
+        CHECK(abs(pos.fx - twoPoint[0][raw]) < 0x10000 / 100);
+        CHECK(abs(pos.fy - twoPoint[1][raw]) < 0x10000 / 100);
+        mismatches += (pos.fx >> 16) != (twoPoint[0][raw] >> 16);
+        mismatches += (pos.fy >> 16) != (twoPoint[1][raw] >> 16);
+    }
+    CHECK_EQ(mismatches, 0);
+    // the fit is centred on the ADC step: raw 0x2A0 maps to 32 + scale/2
+    CHECK(readAt(0x2A0, 0x3C0, &pos));
+    CHECK_EQ(pos.pos.px, 32);
+    CHECK_EQ(pos.pos.py, 24);
+    CHECK(pos.fx - (32 << 16) > 0 && pos.fx - (32 << 16) < 0x10000 / 8);
+
+    // distorted panels: nine taps give sub-pixel accuracy everywhere, where
+    // the two-point model is off by pixels
+    {
+        static const double distortions[][3] = {
+            { 0, 0, 1 }, { 0.035, 0, 1 }, { -0.02, 0.04, 1.03 }, { 0.05, -0.03, 0.97 },
+        };
+        for (i = 0; i < 4; i++) {
+            twlcdcTouchCalibration cal;
+            panel p;
+            int j;
+
+            panelInit(&p, distortions[i][0], distortions[i][1], distortions[i][2]);
+            for (j = 0; j < 9; j++) {
+                panelTap(&p, 32 + (j % 3) * 128, 24 + (j / 3) * 96, &points[j]);
+            }
+            CHECK(twlcdcTouchSetCalibrationPoints(points, 9));
+            CHECK(panelError(&p) < 0.75);
+
+            cal.calX1 = points[0].rawx; cal.calY1 = points[0].rawy;
+            cal.calX1px = points[0].px; cal.calY1px = points[0].py;
+            cal.calX2 = points[8].rawx; cal.calY2 = points[8].rawy;
+            cal.calX2px = points[8].px; cal.calY2px = points[8].py;
+            twlcdcTouchSetCalibration(&cal);
+            if (distortions[i][0] != 0) {
+                CHECK(panelError(&p) > 3);
+            }
+        }
+    }
+
+    // extreme calibration values saturate instead of wrapping around
+    {
+        static const twlcdcTouchCalibration steep = { 0, 0, 0, 0, 1, 1, 32767, 32767 };
+        static const twlcdcTouchCalibration inverted = { 0xFFF, 0xFFF, 0, 0, 0, 0, 32767, 32767 };
+        static const twlcdcTouchCalibration flat = { 0x800, 0x800, 100, 100, 0x800, 0x800, 200, 200 };
+
+        twlcdcTouchSetCalibration(&steep);
+        CHECK(readAt(0xFFF, 0xFFF, &pos));
+        CHECK_EQ(pos.fx, INT32_MAX);
+        CHECK_EQ(pos.pos.px, 319);
+        CHECK_EQ(pos.pos.py, 239);
+        CHECK(pos.flags & TWLCDC_POSITION_OFF_RIGHT);
+
+        // about 8 px per ADC step, evaluated half a step past the point
+        twlcdcTouchSetCalibration(&inverted);
+        CHECK(readAt(0, 0, &pos));
+        CHECK_EQ(pos.pos.px, 319);
+        CHECK(readAt(0xFFF, 0xFFF, &pos));
+        CHECK_EQ(pos.pos.px, 0);
+        CHECK(pos.fx < 0 && pos.fx > -(5 << 16));
+
+        twlcdcTouchSetCalibration(&flat);
+        CHECK(readAt(0x123, 0xF00, &pos));
+
+        points[0] = (twlcdcCalibrationPoint) { 0, 0, -32768, -32768 };
+        points[1] = (twlcdcCalibrationPoint) { 1, 0, 32767, -32768 };
+        points[2] = (twlcdcCalibrationPoint) { 0, 1, -32768, 32767 };
+        CHECK(twlcdcTouchSetCalibrationPoints(points, 3));
+        CHECK(readAt(0xFFF, 0xFFF, &pos));
+        CHECK_EQ(pos.fx, INT32_MAX);
+        CHECK_EQ(pos.fy, INT32_MAX);
+    }
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,108 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - dual contact classification
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "twlcdc.h"
+#include "test.h"
+
+#define SETS 5
+
+// 8 raw steps per pixel
+static const twlcdcTouchCalibration calibration = {
+    0x100, 0x100, 0, 0, 0xB00, 0x880, 320, 240
+};
+
+static const twlcdcContactConfig config = {
+    .dualRatio = 39322,
+    .baselineWeight = 6554,
+    .separationScale = 200,
+    .maxSpread = 48,
+    .jumpDistance = 12
+};
+
+// Five identical sample sets at (px, py), with z2 chosen for a touch
+// resistance of rawx * ratio / 4096, in pressureResistance() units.
+static twlcdcContactType classifyAt(twlcdcContactClassifier *classifier, int px, int py, u32 ratio, twlcdcContact *contact) {
+    twlcdcTouchPosition samples[SETS];
+    int i;
+
+    for (i = 0; i < SETS; i++) {
+        memset(&samples[i], 0, sizeof(samples[i]));
+        samples[i].rawx = 0x100 + px * 8;
+        samples[i].rawy = 0x100 + py * 8;
+        samples[i].z1 = 0x400;
+        samples[i].z2 = 0x400 + ratio / 4;
+    }
+    twlcdcTouchConvertBatch(samples, samples, SETS);
+    return twlcdcContactClassify(classifier, samples, SETS, contact);
+}
+
+static void settle(twlcdcContactClassifier *classifier, int px, int py, u32 ratio) {
+    twlcdcContact contact;
+    int i;
+
+    twlcdcContactInit(classifier, &config);
+    for (i = 0; i < 10; i++) {
+        CHECK_EQ(classifyAt(classifier, px, py, ratio, &contact), TWLCDC_CONTACT_SINGLE);
+    }
+}
+
+int main(void) {
+    twlcdcContactClassifier classifier;
+    twlcdcContact contact;
+    twlcdcTouchPosition samples[SETS];
+    int i;
+
+    twlcdcTouchSetCalibration(&calibration);
+
+    // a second contact: the resistance drops as the position jumps to the
+    // midpoint, which is suppressed
+    settle(&classifier, 100, 100, 4096);
+    CHECK_EQ(classifyAt(&classifier, 140, 100, 1600, &contact), TWLCDC_CONTACT_DUAL);
+    CHECK(contact.suppressed);
+    CHECK_EQ(contact.pos.px, 100);
+    CHECK(contact.separation > 80 && contact.separation < 120);
+    CHECK_EQ(classifyAt(&classifier, 141, 101, 1600, &contact), TWLCDC_CONTACT_DUAL);
+    // the second contact lifts
+    CHECK_EQ(classifyAt(&classifier, 101, 100, 4000, &contact), TWLCDC_CONTACT_SINGLE);
+    CHECK(!contact.suppressed);
+
+    // pressing harder: the same drop without a jump is a single contact
+    settle(&classifier, 100, 100, 4096);
+    CHECK_EQ(classifyAt(&classifier, 102, 101, 1600, &contact), TWLCDC_CONTACT_SINGLE);
+    CHECK_EQ(classifyAt(&classifier, 103, 101, 1600, &contact), TWLCDC_CONTACT_SINGLE);
+
+    // and so is a gradual drop while moving fast
+    settle(&classifier, 40, 100, 4096);
+    for (i = 1; i <= 20; i++) {
+        CHECK_EQ(classifyAt(&classifier, 40 + i * 20, 100, 4096 - i * 150, &contact), TWLCDC_CONTACT_SINGLE);
+    }
+
+    // the contact firms up quickly at the start of a press
+    twlcdcContactInit(&classifier, &config);
+    CHECK_EQ(classifyAt(&classifier, 100, 100, 8000, &contact), TWLCDC_CONTACT_SINGLE);
+    CHECK_EQ(classifyAt(&classifier, 120, 100, 3000, &contact), TWLCDC_CONTACT_SINGLE);
+    CHECK_EQ(classifyAt(&classifier, 140, 100, 2000, &contact), TWLCDC_CONTACT_SINGLE);
+
+    // pen up starts over with a fresh baseline
+    settle(&classifier, 100, 100, 4096);
+    CHECK_EQ(twlcdcContactClassify(&classifier, NULL, 0, &contact), TWLCDC_CONTACT_NONE);
+    CHECK_EQ(classifyAt(&classifier, 200, 100, 1600, &contact), TWLCDC_CONTACT_SINGLE);
+
+    // too few or scattered sample sets
+    settle(&classifier, 100, 100, 4096);
+    for (i = 0; i < SETS; i++) {
+        memset(&samples[i], 0, sizeof(samples[i]));
+        samples[i].rawx = 0x400 + i * 40;
+        samples[i].rawy = 0x400;
+        samples[i].z1 = 0x400;
+        samples[i].z2 = 0x800;
+    }
+    CHECK_EQ(twlcdcContactClassify(&classifier, samples, SETS, &contact), TWLCDC_CONTACT_UNSTABLE);
+    CHECK_EQ(twlcdcContactClassify(&classifier, samples, 2, &contact), TWLCDC_CONTACT_UNSTABLE);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,139 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - pen event tracker
+
+---------------------------------------------------------------------------------*/
+
+#include "twlcdc.h"
+#include "host.h"
+#include "test.h"
+
+#define MS HOST_TICKS_PER_MS
+
+static void feed(twlcdcEventTracker *tracker, u64 tick, bool down, u16 px, u16 py) {
+    twlcdcTouchSample sample = { 0 };
+
+    sample.tick = tick;
+    sample.penDown = down;
+    sample.pos.px = px;
+    sample.pos.py = py;
+    twlcdcEventFeed(tracker, &sample);
+}
+
+// Feed a stroke the way the sampler records it: pen-down samples every
+// millisecond, then a single pen-up sample on the falling edge.
+static u64 stroke(twlcdcEventTracker *tracker, u64 tick, int length, u16 px, u16 py, int dx) {
+    int i;
+
+    for (i = 0; i < length; i++, tick += MS) {
+        feed(tracker, tick, true, px + i * dx, py);
+    }
+    feed(tracker, tick, false, 0, 0);
+    return tick;
+}
+
+static bool next(twlcdcEventTracker *tracker, twlcdcEventType type, u64 tick) {
+    twlcdcEvent event;
+
+    if (!twlcdcEventNext(tracker, &event)) {
+        fprintf(stderr, "no event, expected type %d\n", type);
+        return false;
+    }
+    if (event.type != type || event.tick != tick) {
+        fprintf(stderr, "event %d at %llu, expected %d at %llu\n", event.type,
+            (unsigned long long) event.tick, type, (unsigned long long) tick);
+        return false;
+    }
+    return true;
+}
+
+int main(void) {
+    const twlcdcEventConfig config = { 3 * MS, 5 * MS, 2 };
+    twlcdcEventTracker tracker;
+    twlcdcEvent event;
+    u64 up;
+    int i;
+
+    // a press, then nothing until the application advances the time
+    twlcdcEventInit(&tracker, &config);
+    up = stroke(&tracker, 1000 * MS, 20, 100, 100, 0);
+    CHECK(next(&tracker, TWLCDC_EVENT_DOWN, 1000 * MS));
+    CHECK(!twlcdcEventNext(&tracker, &event));
+    twlcdcEventAdvance(&tracker, up + 4 * MS);
+    CHECK(!twlcdcEventNext(&tracker, &event));
+    twlcdcEventAdvance(&tracker, up + 5 * MS);
+    CHECK(next(&tracker, TWLCDC_EVENT_UP, up));
+    twlcdcEventAdvance(&tracker, up + 50 * MS);
+    CHECK(!twlcdcEventNext(&tracker, &event));
+
+    // two presses with only the sampler's single pen-up sample between
+    // them: the second press resolves the first release
+    twlcdcEventInit(&tracker, &config);
+    up = stroke(&tracker, 0, 20, 100, 100, 0);
+    stroke(&tracker, up + 100 * MS, 20, 200, 150, 0);
+    CHECK(next(&tracker, TWLCDC_EVENT_DOWN, 0));
+    CHECK(next(&tracker, TWLCDC_EVENT_UP, up));
+    CHECK(next(&tracker, TWLCDC_EVENT_DOWN, up + 100 * MS));
+    CHECK(twlcdcEventNext(&tracker, &event) == false);
+
+    // the release keeps the last reported position
+    twlcdcEventInit(&tracker, &config);
+    up = stroke(&tracker, 0, 20, 100, 100, 1);
+    twlcdcEventAdvance(&tracker, up + 10 * MS);
+    while (twlcdcEventNext(&tracker, &event)) {
+        if (event.type == TWLCDC_EVENT_UP) {
+            CHECK(event.px >= 117 && event.px <= 119);
+            CHECK_EQ(event.py, 100);
+        }
+    }
+
+    // a release shorter than the debounce is a bounce
+    twlcdcEventInit(&tracker, &config);
+    up = stroke(&tracker, 0, 20, 100, 100, 0);
+    up = stroke(&tracker, up + 2 * MS, 20, 100, 100, 0);
+    twlcdcEventAdvance(&tracker, up + 5 * MS);
+    CHECK(next(&tracker, TWLCDC_EVENT_DOWN, 0));
+    CHECK(next(&tracker, TWLCDC_EVENT_UP, up));
+    CHECK(!twlcdcEventNext(&tracker, &event));
+
+    // so is a press shorter than the debounce
+    twlcdcEventInit(&tracker, &config);
+    up = stroke(&tracker, 0, 2, 100, 100, 0);
+    twlcdcEventAdvance(&tracker, up + 50 * MS);
+    CHECK(!twlcdcEventNext(&tracker, &event));
+
+    // moves are reported past the threshold only
+    twlcdcEventInit(&tracker, &config);
+    up = stroke(&tracker, 0, 20, 100, 100, 1);
+    CHECK(next(&tracker, TWLCDC_EVENT_DOWN, 0));
+    for (i = 0; twlcdcEventNext(&tracker, &event); i++) {
+        CHECK_EQ(event.type, TWLCDC_EVENT_MOVE);
+        CHECK(event.px > 100);
+    }
+    // DOWN is reported at x=103 after debouncing; 16 more pixels in steps of 3
+    CHECK_EQ(i, 5);
+
+    // polled input: every pen-up sample is fed, so no advance is needed
+    twlcdcEventInit(&tracker, &config);
+    for (i = 0; i < 20; i++) {
+        feed(&tracker, i * 16 * MS, i < 10, 50, 60);
+    }
+    CHECK(next(&tracker, TWLCDC_EVENT_DOWN, 0));
+    CHECK(next(&tracker, TWLCDC_EVENT_UP, 160 * MS));
+    CHECK(!twlcdcEventNext(&tracker, &event));
+
+    // the queue keeps the newest events
+    twlcdcEventInit(&tracker, &config);
+    up = 0;
+    for (i = 0; i < TWLCDC_EVENT_QUEUE_SIZE; i++) {
+        up = stroke(&tracker, up + 10 * MS, 5, 10, 10, 0);
+    }
+    twlcdcEventAdvance(&tracker, up + 10 * MS);
+    for (i = 0; twlcdcEventNext(&tracker, &event); i++) {
+        CHECK_EQ(event.type, i % 2 == 0 ? TWLCDC_EVENT_DOWN : TWLCDC_EVENT_UP);
+    }
+    CHECK_EQ(i, TWLCDC_EVENT_QUEUE_SIZE);
+    CHECK_EQ(event.tick, up);
+
+    return TEST_RESULT();
+}
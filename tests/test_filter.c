@@ -0,0 +1,126 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - sample reduction filters
+
+---------------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include "twlcdc.h"
+#include "filter.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define TRACE_LENGTH 512
+#define TRACE_NOISE 24
+#define TRACE_GLITCH 300
+#define TRACE_GLITCH_EVERY 8
+#define REJECT_SPREAD 64
+
+typedef struct {
+    u32 accepted;
+    u32 rejected;
+    u32 glitchesAccepted;
+    u32 errorSum;
+    u32 errorMax;
+} traceResult;
+
+static int compareU16(const void *a, const void *b) {
+    return *(const u16 *) a - *(const u16 *) b;
+}
+
+// Replay a stroke in which every few readings start with an unsettled
+// conversion, and compare the filtered raw X/Y with the true pen position.
+static traceResult runTrace(simTsc *sim, twlcdcFilter filter) {
+    traceResult result = { 0 };
+    twlcdcTouchPosition pos;
+    int i;
+
+    twlcdcTouchSetFilter(filter, REJECT_SPREAD);
+    sim->seed = 1;
+    sim->noise = TRACE_NOISE;
+    for (i = 0; i < TRACE_LENGTH; i++) {
+        u16 x = 0x400 + i * 4, y = 0x500 + i * 3;
+        bool glitch = (i % TRACE_GLITCH_EVERY) == 0;
+
+        sim->glitch = glitch ? TRACE_GLITCH : 0;
+        simTscSetPen(sim, true, x, y, 0x180, 0x900);
+        if (twlcdcTouchRead(&pos)) {
+            u32 error = abs(pos.rawx - x) + abs(pos.rawy - y);
+            result.accepted++;
+            result.glitchesAccepted += glitch;
+            result.errorSum += error;
+            if (error > result.errorMax) {
+                result.errorMax = error;
+            }
+        } else {
+            result.rejected++;
+        }
+    }
+    sim->glitch = 0;
+    sim->noise = 0;
+    return result;
+}
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+    traceResult mean, median, trimmed, reject;
+    u32 seed = 1;
+    int i, j;
+
+    // kernels against a sort-based reference
+    for (i = 0; i < 200000; i++) {
+        u16 v[5], s[5];
+        u32 sum = 0;
+
+        for (j = 0; j < 5; j++) {
+            seed = seed * 1103515245 + 12345;
+            // mix narrow and full-range inputs, with plenty of ties
+            v[j] = (i & 1) ? (seed >> 16) & 0xFFF : 0x800 + ((seed >> 16) & 7);
+            s[j] = v[j];
+            sum += v[j];
+        }
+        qsort(s, 5, sizeof(u16), compareU16);
+        CHECK_EQ(filterReduce5(v, TWLCDC_FILTER_MEAN), sum / 5);
+        CHECK_EQ(filterReduce5(v, TWLCDC_FILTER_MEDIAN), s[2]);
+        CHECK_EQ(filterReduce5(v, TWLCDC_FILTER_TRIMMED_MEAN), (s[1] + s[2] + s[3]) / 3);
+        CHECK_EQ(filterReduce5(v, TWLCDC_FILTER_REJECT_SPREAD), sum / 5);
+        CHECK_EQ(filterSpread5(v), s[4] - s[0]);
+        if (testFailures > 0) {
+            break;
+        }
+    }
+
+    // accuracy on a glitchy trace, through the library
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    mean = runTrace(&sim, TWLCDC_FILTER_MEAN);
+    median = runTrace(&sim, TWLCDC_FILTER_MEDIAN);
+    trimmed = runTrace(&sim, TWLCDC_FILTER_TRIMMED_MEAN);
+    reject = runTrace(&sim, TWLCDC_FILTER_REJECT_SPREAD);
+
+    // the mean is dragged by the glitch, by 2 * 300/5 raw units
+    CHECK_EQ(mean.accepted, TRACE_LENGTH);
+    CHECK(mean.errorMax >= 2 * TRACE_GLITCH / 5 - TRACE_NOISE);
+
+    // median and trimmed mean shrug it off
+    CHECK_EQ(median.accepted, TRACE_LENGTH);
+    CHECK_EQ(trimmed.accepted, TRACE_LENGTH);
+    CHECK(median.errorMax <= TRACE_NOISE);
+    CHECK(trimmed.errorMax <= TRACE_NOISE);
+    CHECK(median.errorSum < mean.errorSum);
+    CHECK(trimmed.errorSum < mean.errorSum);
+
+    // spread rejection drops exactly the glitched readings
+    CHECK_EQ(reject.glitchesAccepted, 0);
+    CHECK_EQ(reject.rejected, TRACE_LENGTH / TRACE_GLITCH_EVERY);
+    CHECK(reject.errorMax <= TRACE_NOISE);
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
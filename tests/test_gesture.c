@@ -0,0 +1,211 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - gesture recognition over replayed traces
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define MS HOST_TICKS_PER_MS
+#define TRACE_HEADER 16
+#define TRACE_RECORD 48
+#define TRACE_MAX 512
+
+// one raw step is 1/8 pixel on both axes
+static const twlcdcTouchCalibration calibration = {
+    0x100, 0x100, 0, 0, 0xB00, 0x880, 320, 240
+};
+
+static const twlcdcGestureConfig config = {
+    .upDebounce = 10 * MS,
+    .tapTicks = 200 * MS,
+    .doubleTapTicks = 300 * MS,
+    .longPressTicks = 500 * MS,
+    .tapSlop = 8,
+    .swipeDistance = 40,
+    .flickSpeed = 800,
+    .velocityWeight = 19661
+};
+
+typedef struct {
+    u8 data[TRACE_HEADER + TRACE_MAX * TRACE_RECORD];
+    size_t count;
+} testTrace;
+
+static void putLE(u8 *out, u64 value, int bytes) {
+    int i;
+
+    for (i = 0; i < bytes; i++) {
+        out[i] = value >> (i * 8);
+    }
+}
+
+static void traceBegin(testTrace *trace) {
+    memset(trace, 0, sizeof(*trace));
+    memcpy(trace->data, "TWLT", 4);
+    putLE(trace->data + 4, 1, 2);
+    putLE(trace->data + 6, TRACE_RECORD, 2);
+    putLE(trace->data + 8, SYSCLOCK_ARM11, 4);
+}
+
+// one read of the data buffer, as the sampler would make it
+static void traceAdd(testTrace *trace, double ms, bool down, double px, double py) {
+    u8 *record = trace->data + TRACE_HEADER + trace->count++ * TRACE_RECORD;
+    simPen pen = { down, 0x100 + (u16) (px * 8), 0x100 + (u16) (py * 8), 0x180, 0x900 };
+
+    putLE(record, (u64) (ms * MS), 8);
+    simTscEncode(&pen, record + 8);
+}
+
+// a motionless press, with a single pen-up record after it
+static void tracePress(testTrace *trace, double from, double to, double px, double py) {
+    double ms;
+
+    for (ms = from; ms <= to; ms += 4) {
+        traceAdd(trace, ms, true, px, py);
+    }
+    traceAdd(trace, ms, false, 0, 0);
+}
+
+// a straight stroke at constant speed, with a single pen-up record after it
+static void traceStroke(testTrace *trace, double from, double to, double x1, double x2, double py) {
+    double ms;
+
+    for (ms = from; ms <= to; ms += 4) {
+        traceAdd(trace, ms, true, x1 + (x2 - x1) * (ms - from) / (to - from), py);
+    }
+    traceAdd(trace, ms, false, 0, 0);
+}
+
+// Replay a trace through the library and the recognizer; the recognizer is
+// then advanced to the given time, if any.
+static int replayGestures(testTrace *trace, double advanceMs, twlcdcGesture *out, int max) {
+    twlcdcReplay replay;
+    twlcdcBackend backend;
+    twlcdcGestureRecognizer recognizer;
+    twlcdcTouchSample sample;
+    size_t i;
+    int count = 0;
+
+    memset(&backend, 0, sizeof(backend));
+    CHECK(twlcdcReplayInit(&replay, trace->data, TRACE_HEADER + trace->count * TRACE_RECORD));
+    twlcdcReplayBackend(&replay, &backend);
+    twlcdcSetBackend(&backend);
+    twlcdcTouchSetCalibration(&calibration);
+
+    twlcdcGestureInit(&recognizer, &config);
+    for (i = 0; i < trace->count; i++) {
+        memset(&sample, 0, sizeof(sample));
+        sample.penDown = twlcdcTouchRead(&sample.pos);
+        sample.tick = replay.tick;
+        twlcdcGestureFeed(&recognizer, &sample);
+    }
+    if (advanceMs > 0) {
+        twlcdcGestureAdvance(&recognizer, (u64) (advanceMs * MS));
+    }
+    while (count < max && twlcdcGestureNext(&recognizer, &out[count])) {
+        count++;
+    }
+    return count;
+}
+
+int main(void) {
+    static testTrace trace;
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcGesture gestures[TWLCDC_GESTURE_QUEUE_SIZE];
+    int count;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    // tap: reported once the single pen-up record is followed by time
+    traceBegin(&trace);
+    tracePress(&trace, 0, 40, 100, 100);
+    CHECK_EQ(replayGestures(&trace, 0, gestures, TWLCDC_GESTURE_QUEUE_SIZE), 0);
+    count = replayGestures(&trace, 1000, gestures, TWLCDC_GESTURE_QUEUE_SIZE);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(gestures[0].type, TWLCDC_GESTURE_TAP);
+    CHECK_EQ(gestures[0].tick, 44 * MS);
+    CHECK_EQ(gestures[0].px, 100);
+    CHECK_EQ(gestures[0].py, 100);
+
+    // double tap: the second press follows the first one's only pen-up
+    // record, and must not be taken for contact bounce
+    traceBegin(&trace);
+    tracePress(&trace, 0, 40, 100, 100);
+    tracePress(&trace, 150, 190, 102, 101);
+    count = replayGestures(&trace, 1000, gestures, TWLCDC_GESTURE_QUEUE_SIZE);
+    CHECK_EQ(count, 3);
+    CHECK_EQ(gestures[0].type, TWLCDC_GESTURE_TAP);
+    CHECK_EQ(gestures[0].tick, 44 * MS);
+    CHECK_EQ(gestures[1].type, TWLCDC_GESTURE_TAP);
+    CHECK_EQ(gestures[2].type, TWLCDC_GESTURE_DOUBLE_TAP);
+    CHECK_EQ(gestures[2].tick, 194 * MS);
+
+    // two taps too far apart in time are not a double tap
+    traceBegin(&trace);
+    tracePress(&trace, 0, 40, 100, 100);
+    tracePress(&trace, 400, 440, 100, 100);
+    count = replayGestures(&trace, 1000, gestures, TWLCDC_GESTURE_QUEUE_SIZE);
+    CHECK_EQ(count, 2);
+    CHECK_EQ(gestures[1].type, TWLCDC_GESTURE_TAP);
+
+    // contact bounce within the debounce time is one press
+    traceBegin(&trace);
+    tracePress(&trace, 0, 40, 100, 100);
+    tracePress(&trace, 48, 100, 100, 100);
+    count = replayGestures(&trace, 1000, gestures, TWLCDC_GESTURE_QUEUE_SIZE);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(gestures[0].type, TWLCDC_GESTURE_TAP);
+    CHECK_EQ(gestures[0].tick, 104 * MS);
+
+    // long press: reported while held, and no tap on release
+    traceBegin(&trace);
+    tracePress(&trace, 0, 700, 100, 100);
+    count = replayGestures(&trace, 1000, gestures, TWLCDC_GESTURE_QUEUE_SIZE);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(gestures[0].type, TWLCDC_GESTURE_LONG_PRESS);
+    CHECK_EQ(gestures[0].tick, 500 * MS);
+
+    // swipe: 160 px at 200 px/s
+    traceBegin(&trace);
+    traceStroke(&trace, 0, 800, 40, 200, 120);
+    count = replayGestures(&trace, 1000, gestures, TWLCDC_GESTURE_QUEUE_SIZE);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(gestures[0].type, TWLCDC_GESTURE_SWIPE);
+    CHECK_EQ(gestures[0].px, 40);
+    CHECK_EQ(gestures[0].dx, 160);
+    CHECK(gestures[0].dy == 0);
+    // whole pixels arrive every 4 or 8 ms, so the smoothed speed wobbles
+    CHECK(gestures[0].vx > (150 << 16) && gestures[0].vx < (250 << 16));
+
+    // flick: the same stroke at 2000 px/s
+    traceBegin(&trace);
+    traceStroke(&trace, 0, 80, 40, 200, 120);
+    count = replayGestures(&trace, 1000, gestures, TWLCDC_GESTURE_QUEUE_SIZE);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(gestures[0].type, TWLCDC_GESTURE_FLICK);
+    CHECK_EQ(gestures[0].dx, 160);
+
+    // a swipe immediately followed by a tap yields both
+    traceBegin(&trace);
+    traceStroke(&trace, 0, 800, 200, 40, 120);
+    tracePress(&trace, 820, 860, 60, 60);
+    count = replayGestures(&trace, 1000, gestures, TWLCDC_GESTURE_QUEUE_SIZE);
+    CHECK_EQ(count, 2);
+    CHECK_EQ(gestures[0].type, TWLCDC_GESTURE_SWIPE);
+    CHECK_EQ(gestures[0].dx, -160);
+    CHECK_EQ(gestures[1].type, TWLCDC_GESTURE_TAP);
+
+    twlcdcSetBackend(&backend);
+    twlcdcExit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,90 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - hid-style frame input
+
+---------------------------------------------------------------------------------*/
+
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define DOWN(x, y) { true, x, y, 0x180, 0x900 }
+#define UP         { false, 0, 0, 0, 0 }
+
+// touch, one dropped read mid-stroke, release
+static const simPen stroke[] = {
+    UP, DOWN(0x400, 0x500), DOWN(0x480, 0x580), UP, DOWN(0x500, 0x600),
+    DOWN(0x580, 0x680), UP, UP, UP,
+};
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchPositionEx ex, held = { 0 };
+    touchPosition pos;
+    u32 ipc;
+    int frame, presses = 0, releases = 0;
+    bool down[sizeof(stroke) / sizeof(stroke[0])];
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    // each frame costs one read; the accessors reuse it, as often as needed
+    simTscScript(&sim, stroke, sizeof(stroke) / sizeof(stroke[0]));
+    hostSetKeys(KEY_A);
+    for (frame = 0; frame < (int) (sizeof(stroke) / sizeof(stroke[0])); frame++) {
+        ipc = twlcdcGetIpcCount();
+        twlcdcHidScanInput();
+        CHECK_EQ(twlcdcGetIpcCount() - ipc, 1);
+
+        ipc = twlcdcGetIpcCount();
+        down[frame] = (twlcdcHidKeysHeld() & KEY_TOUCH) != 0;
+        presses += (twlcdcHidKeysDown() & KEY_TOUCH) != 0;
+        releases += (twlcdcHidKeysUp() & KEY_TOUCH) != 0;
+        CHECK_EQ(twlcdcHidTouchReadEx(&ex), down[frame]);
+        CHECK_EQ(twlcdcHidKeysHeld() & KEY_TOUCH, down[frame] ? KEY_TOUCH : 0);
+        twlcdcHidTouchRead(&pos);
+        CHECK_EQ(pos.px, ex.pos.px);
+        CHECK_EQ(pos.py, ex.pos.py);
+        CHECK_EQ(twlcdcHidTouchPressure(), ex.pressure);
+        CHECK_EQ(twlcdcGetIpcCount() - ipc, 0);
+
+        // buttons pass through untouched
+        CHECK_EQ(twlcdcHidKeysHeld() & ~KEY_TOUCH, KEY_A);
+        CHECK_EQ(twlcdcHidKeysDown() & ~KEY_TOUCH, frame == 0 ? KEY_A : 0);
+        CHECK_EQ(twlcdcHidKeysUp() & ~KEY_TOUCH, 0);
+
+        if (frame == 2) {
+            held = ex;
+        } else if (frame == 3) {
+            // the dropped read repeats the previous sample
+            CHECK_EQ(ex.pos.rawx, held.pos.rawx);
+            CHECK_EQ(ex.pos.px, held.pos.px);
+            CHECK_EQ(ex.pressure, held.pressure);
+        } else if (!down[frame]) {
+            CHECK_EQ(pos.px, 0);
+            CHECK_EQ(ex.pressure, 0);
+        }
+    }
+
+    // one press, one release, and the release waits for a second pen-up read
+    CHECK_EQ(presses, 1);
+    CHECK_EQ(releases, 1);
+    CHECK(!down[0]);
+    CHECK(down[1] && down[2] && down[3] && down[4] && down[5] && down[6]);
+    CHECK(!down[7] && !down[8]);
+
+    // a failed read with the pen up does not press
+    simTscSetPen(&sim, false, 0, 0, 0, 0);
+    hostSetKeys(0);
+    twlcdcHidScanInput();
+    CHECK_EQ(twlcdcHidKeysDown() & KEY_TOUCH, 0);
+    CHECK_EQ(twlcdcHidKeysUp(), KEY_A);
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,63 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - pen-down notification
+
+---------------------------------------------------------------------------------*/
+
+#include <pthread.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define MS 1000000LL
+
+static int waitResult;
+
+static void *waiterThread(void *arg) {
+    (void) arg;
+    waitResult = twlcdcWaitForPen(-1);
+    return NULL;
+}
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+    pthread_t waiter;
+    int i;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    CHECK(!twlcdcWaitForPen(0));
+    CHECK(twlcdcPenNotifyStart(1 * MS, 8 * MS));
+    CHECK(!twlcdcPenNotifyStart(1 * MS, 8 * MS));
+
+    // idle: waits time out
+    CHECK(!twlcdcWaitForPen(20 * MS));
+
+    // contact is reported, and stays reported while the pen is down
+    simTscSetPen(&sim, true, 0x800, 0x700, 0x180, 0x900);
+    CHECK(twlcdcWaitForPen(-1));
+    CHECK(twlcdcWaitForPen(0));
+    twlcdcPenNotifyStop();
+    CHECK(!twlcdcWaitForPen(0));
+
+    // stopping releases waiters as "not down", never as a pen-down
+    simTscSetPen(&sim, false, 0, 0, 0, 0);
+    for (i = 0; i < 20; i++) {
+        CHECK(twlcdcPenNotifyStart(1 * MS, 8 * MS));
+        waitResult = -1;
+        pthread_create(&waiter, NULL, waiterThread, NULL);
+        svcSleepThread(i * MS / 4);
+        twlcdcPenNotifyStop();
+        pthread_join(waiter, NULL);
+        CHECK_EQ(waitResult, 0);
+    }
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
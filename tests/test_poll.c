@@ -0,0 +1,71 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - IPC cost of twlcdcTouchPoll()
+
+---------------------------------------------------------------------------------*/
+
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchPosition pos, ref;
+    u32 ipc;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    // pen down: the classic PenDown() + Read() pair costs two round-trips
+    simTscSetPen(&sim, true, 0x800, 0x700, 0x180, 0x900);
+    ipc = twlcdcGetIpcCount();
+    CHECK(twlcdcTouchPenDown());
+    CHECK(twlcdcTouchRead(&ref));
+    CHECK_EQ(twlcdcGetIpcCount() - ipc, 2);
+
+    // the checked poll costs the same, the fast poll only one
+    ipc = twlcdcGetIpcCount();
+    CHECK(twlcdcTouchPoll(&pos, TWLCDC_POLL_CHECKED));
+    CHECK_EQ(twlcdcGetIpcCount() - ipc, 2);
+    CHECK_EQ(pos.px, ref.px);
+    CHECK_EQ(pos.py, ref.py);
+
+    simTscClearCounters(&sim);
+    ipc = twlcdcGetIpcCount();
+    CHECK(twlcdcTouchPoll(&pos, TWLCDC_POLL_FAST));
+    CHECK_EQ(twlcdcGetIpcCount() - ipc, 1);
+    CHECK_EQ(sim.reads[SIM_BANK_TOUCHCNT], 0);
+    CHECK_EQ(sim.reads[SIM_BANK_TOUCHDATA], 1);
+    CHECK_EQ(pos.px, ref.px);
+    CHECK_EQ(pos.py, ref.py);
+    CHECK_EQ(pos.rawx, ref.rawx);
+    CHECK_EQ(pos.z1, ref.z1);
+
+    // pen up: the checked poll stops after the status registers, the fast
+    // poll infers pen-up from the data buffer; both in one round-trip
+    simTscSetPen(&sim, false, 0, 0, 0, 0);
+    simTscClearCounters(&sim);
+    ipc = twlcdcGetIpcCount();
+    CHECK(!twlcdcTouchPoll(&pos, TWLCDC_POLL_CHECKED));
+    CHECK_EQ(twlcdcGetIpcCount() - ipc, 1);
+    CHECK_EQ(sim.reads[SIM_BANK_TOUCHDATA], 0);
+
+    ipc = twlcdcGetIpcCount();
+    CHECK(!twlcdcTouchPoll(&pos, TWLCDC_POLL_FAST));
+    CHECK_EQ(twlcdcGetIpcCount() - ipc, 1);
+
+    // the counter tracks backend traffic exactly
+    simTscClearCounters(&sim);
+    ipc = twlcdcGetIpcCount();
+    twlcdcTouchPenDown();
+    twlcdcTouchPoll(&pos, TWLCDC_POLL_FAST);
+    CHECK_EQ(twlcdcGetIpcCount() - ipc, simTscAccesses(&sim));
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,151 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - fixed point pressure against a double reference
+
+---------------------------------------------------------------------------------*/
+
+#include <math.h>
+#include "twlcdc.h"
+#include "pressure.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+static double referencePressure(const twlcdcPressureModel *model, u32 resistance) {
+    return (double) model->maxPressure * model->maxRadius * 65536.0 / resistance;
+}
+
+static void checkPressure(const twlcdcPressureModel *model, u32 resistance) {
+    double expected = referencePressure(model, resistance);
+    u32 actual = pressureFromResistance(resistance);
+
+    // saturates instead of wrapping
+    if (expected > 4294967295.0) {
+        expected = 4294967295.0;
+    }
+    if (fabs(actual - expected) > expected * 1e-7 + 1) {
+        CHECK_EQ(actual, (u32) expected);
+    }
+}
+
+int main(void) {
+    static const u16 rawxs[] = { 1, 0x2A0, 0x800, 0xD40, 0xFFF };
+    twlcdcPressureModel model;
+    double worst = 0;
+    u32 d, z1, z2;
+    int i;
+
+    // reciprocal, over every 24-bit divisor and a spread of larger ones
+    for (d = 1; d < (1 << 24) && testFailures == 0; d++) {
+        int n;
+        u32 y = fixRecip(d, &n);
+        CHECK(fabs(ldexp((double) y * d, -(62 - n)) - 1) < ldexp(1, -27));
+    }
+    for (d = 0xFFFFFFFF; d >= (1 << 24) && testFailures == 0; d -= 0x1001) {
+        int n;
+        u32 y = fixRecip(d, &n);
+        CHECK(fabs(ldexp((double) y * d, -(62 - n)) - 1) < ldexp(1, -27));
+    }
+
+    // resistance, over the full 12-bit Z1/Z2 range
+    for (i = 0; i < 5; i++) {
+        u16 rawx = rawxs[i];
+        for (z1 = 0; z1 < 0x1000 && testFailures == 0; z1++) {
+            for (z2 = 0; z2 < 0x1000; z2++) {
+                u32 actual = pressureResistance(rawx, z1, z2);
+                u64 ratio, expected;
+
+                if (z1 == 0 || z2 <= z1) {
+                    CHECK_EQ(actual, 0);
+                    continue;
+                }
+                // the reference floors z2 * 4096 / z1 before scaling, and
+                // saturates rather than wrapping at high rawx
+                ratio = (z2 * 4096) / z1;
+                expected = ratio <= 4096 ? 0 : rawx * (ratio - 4096);
+                expected = expected > 0xFFFFFFFF ? 0xFFFFFFFF : expected;
+                if (actual != expected) {
+                    CHECK_EQ(actual, expected);
+                    break;
+                }
+            }
+        }
+    }
+
+    // pressure, over every resistance the 12-bit inputs can produce, for
+    // the default model and a couple of per-device ones
+    for (i = 0; i < 3; i++) {
+        static const twlcdcPressureModel models[] = {
+            { 0x00DE0000, 128 }, { 0x00010000, 1 }, { 0xFFFFFFFF, 0xFFFF },
+        };
+        u32 r;
+
+        pressureSetModel(&models[i]);
+        pressureGetModel(&model);
+        CHECK_EQ(model.maxPressure, models[i].maxPressure);
+        for (r = 1; r < 0x1000000 && testFailures == 0; r++) {
+            checkPressure(&model, r);
+        }
+        for (r = 0xFFFFFFFF; r >= 0x1000000 && testFailures == 0; r -= 0xFFF) {
+            checkPressure(&model, r);
+        }
+        for (r = 0x1000; r < 0x100000; r += 7) {
+            double expected = referencePressure(&model, r);
+            // relative accuracy, where the output has enough integer bits
+            if (expected < 4294967295.0 && expected >= 0x1000000) {
+                double error = fabs(pressureFromResistance(r) - expected) / expected;
+                worst = error > worst ? error : worst;
+            }
+        }
+    }
+    CHECK(worst < 1e-7);
+
+    // models small enough that ordinary resistances give less than one
+    // unit of pressure: the result rounds to 0 instead of over-shifting
+    {
+        static const twlcdcPressureModel tiny[] = { { 1, 1 }, { 3, 5 }, { 0x100, 0x3F } };
+        static const u32 resistances[] = { 0x10000, 0x123456, 0x80000000, 0xFFFFFFFF };
+        int j;
+
+        for (i = 0; i < 3; i++) {
+            pressureSetModel(&tiny[i]);
+            for (j = 0; j < 4; j++) {
+                checkPressure(&tiny[i], resistances[j]);
+            }
+            CHECK_EQ(pressureFromResistance(0xFFFFFFFF), 0);
+            checkPressure(&tiny[i], 1);
+        }
+    }
+
+    // through the library, with the default model
+    {
+        simTsc sim;
+        twlcdcBackend backend;
+        twlcdcTouchPositionEx pos;
+
+        hostReset();
+        simTscInit(&sim);
+        simTscBackend(&sim, &backend);
+        twlcdcSetBackend(&backend);
+        CHECK(twlcdcInit());
+
+        model.maxPressure = 0x00DE0000;
+        model.maxRadius = 128;
+        twlcdcTouchSetPressureModel(&model);
+
+        simTscSetPen(&sim, true, 0xFFF, 0x700, 0x010, 0xFFF);
+        CHECK(twlcdcTouchPollEx(&pos, TWLCDC_POLL_FAST));
+        CHECK_EQ(pos.resistance, 0xFFFULL * (0xFFF * 4096 / 0x010 - 4096));
+        CHECK(fabs(pos.pressure - referencePressure(&model, pos.resistance)) <= 1);
+
+        // no pressure when Z2 <= Z1
+        simTscSetPen(&sim, true, 0x800, 0x700, 0x900, 0x900);
+        CHECK(twlcdcTouchPollEx(&pos, TWLCDC_POLL_CHECKED));
+        CHECK_EQ(pos.resistance, 0);
+        CHECK_EQ(pos.pressure, 0);
+
+        twlcdcExit();
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,130 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - conversion profiles and their register sequences
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+static void checkWrite(const simTsc *sim, size_t index, u8 reg, u8 size) {
+    CHECK(index < sim->logCount);
+    CHECK_EQ(sim->log[index].bank, SIM_BANK_TOUCHCNT);
+    CHECK_EQ(sim->log[index].reg, reg);
+    CHECK_EQ(sim->log[index].size, size);
+}
+
+// Scan timer interval: bits 4-6, in milliseconds, with 0 for 8 ms.
+static int scanIntervalMs(u8 scanTimer) {
+    int interval = (scanTimer >> 4) & 7;
+    return interval != 0 ? interval : 8;
+}
+
+// Controller registers match a conversion configuration.
+static void checkRegisters(const simTsc *sim, const twlcdcTscConfig *config) {
+    CHECK_EQ((sim->touchcnt[0x02] >> 3) & 3, config->clockDivider);
+    CHECK_EQ(sim->touchcnt[0x03], config->conversionMode);
+    CHECK_EQ((sim->touchcnt[0x04] >> 4) & 7, config->prechargeTime);
+    CHECK_EQ(sim->touchcnt[0x04] & 7, config->senseTime);
+    CHECK_EQ(sim->touchcnt[0x05] & 7, config->stabilizationTime);
+    CHECK_EQ((sim->touchcnt[0x0E] >> 3) & 7, config->bufferTrigger);
+    CHECK_EQ(sim->touchcnt[0x0E] & 0xC0, 0x80);
+    CHECK_EQ(sim->touchcnt[0x0F], config->scanTimer);
+    CHECK_EQ(sim->touchcnt[0x12] & 7, config->scanTimerClock);
+}
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTscConfig config, custom;
+    u8 powerOn[128];
+    int profile;
+
+    hostReset();
+    simTscInit(&sim);
+    // unrelated bits in the shared registers must be preserved
+    sim.touchcnt[0x02] |= 0x81;
+    sim.touchcnt[0x04] |= 0x88;
+    sim.touchcnt[0x12] |= 0x30;
+    memcpy(powerOn, sim.touchcnt, sizeof(powerOn));
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+
+    // before initialization, a profile is only recorded
+    CHECK(twlcdcSetProfile(TWLCDC_PROFILE_LOW_POWER));
+    CHECK_EQ(simTscAccesses(&sim), 0);
+    CHECK(twlcdcInit());
+    twlcdcGetTscConfig(&config);
+    checkRegisters(&sim, &config);
+    CHECK_EQ(scanIntervalMs(sim.touchcnt[0x0F]), 8);
+
+    for (profile = TWLCDC_PROFILE_DEFAULT; profile <= TWLCDC_PROFILE_HIGH_ACCURACY; profile++) {
+        simTscClearCounters(&sim);
+        CHECK(twlcdcSetProfile(profile));
+        twlcdcGetTscConfig(&config);
+
+        // no reads: the shadow registers are reused; buffer mode is
+        // stopped first and only restarted once everything else is written
+        CHECK_EQ(sim.reads[SIM_BANK_TOUCHCNT], 0);
+        CHECK_EQ(sim.logCount, 5);
+        checkWrite(&sim, 0, 0x0E, 1);
+        CHECK_EQ(sim.log[0].data[0] & 0x80, 0);
+        checkWrite(&sim, 1, 0x02, 4);
+        checkWrite(&sim, 2, 0x0E, 2);
+        CHECK_EQ(sim.log[2].data[0] & 0x80, 0);
+        checkWrite(&sim, 3, 0x12, 1);
+        checkWrite(&sim, 4, 0x0E, 1);
+        CHECK_EQ(sim.log[4].data[0] & 0x80, 0x80);
+
+        checkRegisters(&sim, &config);
+        CHECK_EQ(sim.touchcnt[0x02] & 0x81, 0x81);
+        CHECK_EQ(sim.touchcnt[0x04] & 0x88, 0x88);
+        CHECK_EQ(sim.touchcnt[0x12] & 0x30, 0x30);
+    }
+
+    // the profiles differ where documented
+    CHECK(twlcdcSetProfile(TWLCDC_PROFILE_DEFAULT));
+    CHECK_EQ(sim.touchcnt[0x03], 0x8B);
+    CHECK_EQ(sim.touchcnt[0x0F], 0xA0);
+    CHECK_EQ(scanIntervalMs(sim.touchcnt[0x0F]), 2);
+    CHECK(twlcdcSetProfile(TWLCDC_PROFILE_LOW_LATENCY));
+    twlcdcGetTscConfig(&config);
+    CHECK(config.clockDivider < 3 && (config.scanTimer & 0x80));
+    CHECK_EQ(scanIntervalMs(config.scanTimer), 1);
+    CHECK(twlcdcSetProfile(TWLCDC_PROFILE_LOW_POWER));
+    twlcdcGetTscConfig(&config);
+    CHECK((config.scanTimer & 0x80) && scanIntervalMs(config.scanTimer) == 8);
+    CHECK(twlcdcSetProfile(TWLCDC_PROFILE_HIGH_ACCURACY));
+    twlcdcGetTscConfig(&config);
+    CHECK(config.senseTime > 6 && config.scanTimer == 0xA0);
+
+    // invalid profiles are refused without touching the controller
+    simTscClearCounters(&sim);
+    CHECK(!twlcdcSetProfile((twlcdcProfile) 4));
+    CHECK(!twlcdcSetProfile((twlcdcProfile) -1));
+    CHECK_EQ(simTscAccesses(&sim), 0);
+
+    // a raw configuration, kept across suspend and resume
+    custom = config;
+    custom.clockDivider = 2;
+    custom.prechargeTime = 1;
+    custom.scanTimer = 0xC4;
+    twlcdcSetTscConfig(&custom);
+    checkRegisters(&sim, &custom);
+    hostAptSignal(APTHOOK_ONSUSPEND);
+    CHECK_EQ(sim.touchcnt[0x0F], powerOn[0x0F]);
+    hostAptSignal(APTHOOK_ONRESTORE);
+    checkRegisters(&sim, &custom);
+
+    // exit restores the power-on values
+    twlcdcExit();
+    CHECK(memcmp(&sim.touchcnt[0x02], &powerOn[0x02], 4) == 0);
+    CHECK_EQ(sim.touchcnt[0x0E], powerOn[0x0E]);
+    CHECK_EQ(sim.touchcnt[0x0F], powerOn[0x0F]);
+    CHECK_EQ(sim.touchcnt[0x12], powerOn[0x12]);
+
+    return TEST_RESULT();
+}
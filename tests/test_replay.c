@@ -0,0 +1,194 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - trace capture and deterministic replay
+
+---------------------------------------------------------------------------------*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define MS HOST_TICKS_PER_MS
+#define STROKE_LENGTH 200
+#define TRACE_HEADER 16
+#define TRACE_RECORD 48
+
+typedef struct {
+    s32 fx[STROKE_LENGTH + 20];
+    bool down[STROKE_LENGTH + 20];
+    twlcdcEvent events[TWLCDC_EVENT_QUEUE_SIZE];
+    int eventCount;
+} replayResult;
+
+static const twlcdcSmootherConfig smoothing = { .minCutoff = 1 << 8, .beta = 6554 };
+static const twlcdcEventConfig eventConfig = { 3 * MS, 5 * MS, 32 };
+
+static void *readerMain(void *arg) {
+    twlcdcTouchPosition pos;
+    int i;
+
+    for (i = 0; i < 20000; i++) {
+        twlcdcTouchRead(&pos);
+    }
+    return NULL;
+}
+
+// Replay a capture with smoothing and event tracking, the host clock
+// running at an unrelated rate.
+static void replay(const u8 *data, size_t size, u64 clockStep, replayResult *result) {
+    twlcdcReplay state;
+    twlcdcBackend backend;
+    twlcdcEventTracker tracker;
+    twlcdcTouchPositionEx pos;
+    int i;
+
+    memset(&backend, 0, sizeof(backend));
+    memset(result, 0, sizeof(*result));
+
+    // smoothed positions
+    CHECK(twlcdcReplayInit(&state, data, size));
+    twlcdcReplayBackend(&state, &backend);
+    twlcdcSetBackend(&backend);
+    twlcdcTouchSetSmoothing(&smoothing);
+    for (i = 0; i < STROKE_LENGTH + 20; i++) {
+        hostAdvance(clockStep);
+        result->down[i] = twlcdcTouchReadEx(&pos);
+        result->fx[i] = result->down[i] ? pos.fx : 0;
+    }
+    twlcdcTouchSetSmoothing(NULL);
+
+    // debounced events
+    CHECK(twlcdcReplayInit(&state, data, size));
+    twlcdcEventInit(&tracker, &eventConfig);
+    for (i = 0; i < STROKE_LENGTH + 20; i++) {
+        hostAdvance(clockStep);
+        twlcdcEventPoll(&tracker, TWLCDC_POLL_FAST);
+    }
+    twlcdcEventAdvance(&tracker, state.tick + 100 * MS);
+    while (result->eventCount < TWLCDC_EVENT_QUEUE_SIZE
+        && twlcdcEventNext(&tracker, &result->events[result->eventCount])) {
+        result->eventCount++;
+    }
+}
+
+int main(void) {
+    static simPen stroke[STROKE_LENGTH + 1];
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchPosition pos;
+    replayResult first, second;
+    s32 captured[STROKE_LENGTH];
+    FILE *file;
+    u8 *data;
+    long size;
+    int i;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    // capture a stroke sampled at irregular intervals
+    for (i = 0; i < STROKE_LENGTH; i++) {
+        stroke[i] = (simPen) { true, 0x400 + i * 8, 0x600 + i * 3, 0x180, 0x900 };
+    }
+    stroke[STROKE_LENGTH] = (simPen) { false, 0, 0, 0, 0 };
+    simTscScript(&sim, stroke, STROKE_LENGTH + 1);
+    sim.pen = stroke[0];
+
+    file = tmpfile();
+    CHECK(file != NULL);
+    CHECK(!twlcdcCaptureStart(NULL));
+    CHECK(twlcdcCaptureStart(file));
+    CHECK(!twlcdcCaptureStart(file));
+    for (i = 0; i < STROKE_LENGTH; i++) {
+        hostAdvance(MS + (i % 7) * HOST_TICKS_PER_US * 100);
+        CHECK(twlcdcTouchRead(&pos));
+        captured[i] = pos.px;
+    }
+    hostAdvance(MS);
+    CHECK(!twlcdcTouchRead(&pos));
+    CHECK(twlcdcCaptureStop());
+    CHECK(twlcdcCaptureStop());
+
+    size = ftell(file);
+    CHECK_EQ(size, TRACE_HEADER + (STROKE_LENGTH + 1) * TRACE_RECORD);
+    data = malloc(size);
+    rewind(file);
+    CHECK(fread(data, 1, size, file) == (size_t) size);
+    fclose(file);
+
+    // replays are identical whatever the clock does, and so are the
+    // smoothed positions and event times derived from them
+    replay(data, size, 3 * MS, &first);
+    replay(data, size, 17, &second);
+    CHECK(memcmp(first.fx, second.fx, sizeof(first.fx)) == 0);
+    CHECK(memcmp(first.down, second.down, sizeof(first.down)) == 0);
+    CHECK_EQ(first.eventCount, second.eventCount);
+    CHECK(memcmp(first.events, second.events, sizeof(first.events)) == 0);
+
+    // the replayed stroke is the captured one
+    for (i = 0; i < STROKE_LENGTH; i++) {
+        CHECK(first.down[i]);
+    }
+    for (i = STROKE_LENGTH + 1; i < STROKE_LENGTH + 20; i++) {
+        CHECK(!first.down[i]);
+    }
+    CHECK(abs((first.fx[STROKE_LENGTH - 1] >> 16) - captured[STROKE_LENGTH - 1]) <= 1);
+
+    // events carry the captured ticks
+    CHECK(first.eventCount >= 2);
+    CHECK_EQ(first.events[0].type, TWLCDC_EVENT_DOWN);
+    CHECK_EQ(first.events[first.eventCount - 1].type, TWLCDC_EVENT_UP);
+    {
+        u64 start = data[TRACE_HEADER] | (u64) data[TRACE_HEADER + 1] << 8
+            | (u64) data[TRACE_HEADER + 2] << 16 | (u64) data[TRACE_HEADER + 3] << 24;
+        CHECK_EQ(first.events[0].tick, start);
+    }
+    free(data);
+
+    // a failed block write ends the capture, and is reported on stop
+    {
+        static u8 small[TRACE_HEADER + 200 * TRACE_RECORD];
+
+        twlcdcSetBackend(&backend);
+        file = fmemopen(small, sizeof(small), "wb");
+        setvbuf(file, NULL, _IONBF, 0);
+        simTscSetPen(&sim, true, 0x800, 0x800, 0x180, 0x900);
+        CHECK(twlcdcCaptureStart(file));
+        for (i = 0; i < 1000; i++) {
+            twlcdcTouchRead(&pos);
+        }
+        CHECK(!twlcdcCaptureStop());
+        CHECK(twlcdcCaptureStop());
+        CHECK(ftell(file) <= (long) sizeof(small));
+        fclose(file);
+    }
+
+    // starting and stopping a capture while another thread reads
+    {
+        pthread_t reader;
+
+        twlcdcSetBackend(&backend);
+        simTscSetPen(&sim, true, 0x800, 0x800, 0x180, 0x900);
+        pthread_create(&reader, NULL, readerMain, NULL);
+        for (i = 0; i < 200; i++) {
+            file = tmpfile();
+            CHECK(twlcdcCaptureStart(file));
+            sched_yield();
+            twlcdcCaptureStop();
+            size = ftell(file);
+            CHECK((size - TRACE_HEADER) % TRACE_RECORD == 0);
+            fclose(file);
+        }
+        pthread_join(reader, NULL);
+    }
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
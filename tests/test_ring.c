@@ -0,0 +1,108 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - single-producer/single-consumer sample ring
+
+---------------------------------------------------------------------------------*/
+
+#include <pthread.h>
+#include <string.h>
+#include "ring.h"
+#include "test.h"
+
+#define THREADED_COUNT 1000000
+
+static twlcdcRing shared;
+static ringSample sharedStorage[64];
+
+static void *producerMain(void *arg) {
+    ringSample sample;
+    uint32_t i;
+
+    memset(&sample, 0, sizeof(sample));
+    for (i = 0; i < THREADED_COUNT; i++) {
+        sample.tick = i;
+        sample.rawx = (uint16_t) i;
+        sample.rawy = (uint16_t) ~i;
+        while (!ringPush(&shared, &sample)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    twlcdcRing ring;
+    ringSample storage[8];
+    ringSample sample, out[16];
+    uint32_t i;
+
+    memset(&sample, 0, sizeof(sample));
+    ringInit(&ring, storage, 8);
+
+    // empty
+    CHECK_EQ(ringDrain(&ring, out, 16), 0);
+
+    // fill to capacity, the ninth push is rejected
+    for (i = 0; i < 8; i++) {
+        sample.tick = i;
+        CHECK(ringPush(&ring, &sample));
+    }
+    sample.tick = 8;
+    CHECK(!ringPush(&ring, &sample));
+
+    // partial drain keeps order
+    CHECK_EQ(ringDrain(&ring, out, 3), 3);
+    for (i = 0; i < 3; i++) {
+        CHECK_EQ(out[i].tick, i);
+    }
+
+    // wrap around the end of the storage
+    for (i = 8; i < 11; i++) {
+        sample.tick = i;
+        CHECK(ringPush(&ring, &sample));
+    }
+    CHECK(!ringPush(&ring, &sample));
+    CHECK_EQ(ringDrain(&ring, out, 16), 8);
+    for (i = 0; i < 8; i++) {
+        CHECK_EQ(out[i].tick, i + 3);
+    }
+    CHECK_EQ(ringDrain(&ring, out, 16), 0);
+
+    // wrap the 32-bit indices themselves
+    ring.head = ring.tail = 0xFFFFFFFE;
+    for (i = 0; i < 5; i++) {
+        sample.tick = 100 + i;
+        CHECK(ringPush(&ring, &sample));
+    }
+    CHECK_EQ(ringDrain(&ring, out, 16), 5);
+    CHECK_EQ(out[4].tick, 104);
+
+    // concurrent producer and consumer: every sample arrives exactly once,
+    // in order, and intact
+    {
+        pthread_t producer;
+        uint32_t expected = 0;
+
+        ringInit(&shared, sharedStorage, 64);
+        pthread_create(&producer, NULL, producerMain, NULL);
+        while (expected < THREADED_COUNT) {
+            size_t n = ringDrain(&shared, out, 16);
+            size_t j;
+            for (j = 0; j < n; j++, expected++) {
+                if (out[j].tick != expected || out[j].rawx != (uint16_t) expected
+                        || out[j].rawy != (uint16_t) ~expected) {
+                    CHECK_EQ(out[j].tick, expected);
+                    expected = THREADED_COUNT;
+                    break;
+                }
+            }
+            if (n == 0) {
+                sched_yield();
+            }
+        }
+        pthread_join(producer, NULL);
+        CHECK_EQ(ringDrain(&shared, out, 16), 0);
+    }
+
+    return TEST_RESULT();
+}
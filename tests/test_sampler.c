@@ -0,0 +1,121 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - background sampler against the simulated controller
+
+---------------------------------------------------------------------------------*/
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+// Drain until at least `want` samples arrived, or give up after ~1s.
+static size_t drainAtLeast(twlcdcTouchSample *buf, size_t max, size_t want) {
+    size_t total = 0;
+    int tries;
+
+    for (tries = 0; tries < 1000 && total < want; tries++) {
+        total += twlcdcSamplerDrain(buf + total, max - total);
+        if (total < want) {
+            usleep(1000);
+        }
+    }
+    return total;
+}
+
+static volatile bool draining;
+
+static void *drainMain(void *arg) {
+    static twlcdcTouchSample buf[256];
+
+    while (draining) {
+        twlcdcSamplerDrain(buf, 256);
+    }
+    return NULL;
+}
+
+int main(void) {
+    static twlcdcTouchSample buf[4096];
+    simTsc sim;
+    twlcdcBackend backend;
+    size_t n, i;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    CHECK(!twlcdcSamplerStart(0, 64));
+    CHECK(!twlcdcSamplerStart(1000, 0));
+    CHECK(twlcdcSamplerStart(1000, 100));
+    CHECK(!twlcdcSamplerStart(1000, 100));
+
+    // pen down: samples arrive in order, timestamped one period apart
+    simTscSetPen(&sim, true, 0x800, 0x700, 0x180, 0x900);
+    n = drainAtLeast(buf, 4096, 32);
+    CHECK(n >= 32);
+    for (i = 0; i < n; i++) {
+        if (!buf[i].penDown) {
+            // the sampler may have caught the very first poll before the pen
+            CHECK_EQ(i, 0);
+            continue;
+        }
+        CHECK(buf[i].pos.px >= 160 && buf[i].pos.px <= 161);
+        CHECK(buf[i].pos.py >= 98 && buf[i].pos.py <= 99);
+        if (i > 0 && buf[i - 1].penDown) {
+            CHECK(buf[i].tick > buf[i - 1].tick);
+        }
+    }
+
+    // pen up: exactly one pen-up record, then nothing
+    simTscSetPen(&sim, false, 0, 0, 0, 0);
+    for (i = 0; i < 1000; i++) {
+        n = twlcdcSamplerDrain(buf, 4096);
+        if (n > 0 && !buf[n - 1].penDown) {
+            break;
+        }
+        usleep(1000);
+    }
+    CHECK(n > 0 && !buf[n - 1].penDown);
+    usleep(20000);
+    CHECK_EQ(twlcdcSamplerDrain(buf, 4096), 0);
+
+    // nothing drained while the pen is down: the ring fills and drops
+    twlcdcSamplerDropped();
+    simTscSetPen(&sim, true, 0x800, 0x700, 0x180, 0x900);
+    for (i = 0; i < 1000 && twlcdcSamplerDropped() == 0; i++) {
+        usleep(1000);
+    }
+    CHECK(i < 1000);
+    CHECK_EQ(twlcdcSamplerDrain(buf, 4096), 128);
+
+    twlcdcSamplerStop();
+    CHECK_EQ(twlcdcSamplerDrain(buf, 4096), 0);
+
+    // stopping, starting and exiting while a consumer keeps draining
+    {
+        pthread_t consumer;
+
+        draining = true;
+        pthread_create(&consumer, NULL, drainMain, NULL);
+        for (i = 0; i < 2000; i++) {
+            CHECK(twlcdcSamplerStart(100000, 1024));
+            sched_yield();
+            if (i % 500 == 499) {
+                twlcdcExit();
+                CHECK(twlcdcInit());
+            } else {
+                twlcdcSamplerStop();
+            }
+        }
+        draining = false;
+        pthread_join(consumer, NULL);
+    }
+    twlcdcExit();
+
+    return TEST_RESULT();
+}
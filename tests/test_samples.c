@@ -0,0 +1,67 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - twlcdcTouchReadSamples()
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchPosition out[TWLCDC_TOUCH_SAMPLES_PER_READ + 1], pos;
+    twlcdcTouchSample latest;
+    twlcdcStats stats;
+    u32 ipc;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+    simTscSetPen(&sim, true, 0x800, 0x700, 0x180, 0x900);
+
+    // an empty output array costs nothing and changes nothing
+    twlcdcResetStats();
+    simTscClearCounters(&sim);
+    ipc = twlcdcGetIpcCount();
+    CHECK_EQ(twlcdcTouchReadSamples(NULL, 0), 0);
+    CHECK_EQ(twlcdcGetIpcCount() - ipc, 0);
+    CHECK_EQ(simTscAccesses(&sim), 0);
+    CHECK(!twlcdcTouchGetLatest(&latest));
+    CHECK(twlcdcGetStats(&stats));
+    CHECK_EQ(stats.invalidSamples, 0);
+    CHECK_EQ(stats.latency[TWLCDC_STAT_READ].count, 0);
+
+    // one read returns every sample set, however large the array
+    ipc = twlcdcGetIpcCount();
+    CHECK_EQ(twlcdcTouchReadSamples(out, TWLCDC_TOUCH_SAMPLES_PER_READ + 1), TWLCDC_TOUCH_SAMPLES_PER_READ);
+    CHECK_EQ(twlcdcGetIpcCount() - ipc, 1);
+    CHECK(twlcdcTouchRead(&pos));
+    CHECK_EQ(out[0].px, pos.px);
+    CHECK_EQ(out[TWLCDC_TOUCH_SAMPLES_PER_READ - 1].py, pos.py);
+
+    // a short array is filled oldest first
+    memset(out, 0, sizeof(out));
+    CHECK_EQ(twlcdcTouchReadSamples(out, 2), 2);
+    CHECK_EQ(out[1].rawx, 0x800);
+    CHECK_EQ(out[2].rawx, 0);
+
+    // sample sets are not filtered against each other
+    sim.glitch = 0x100;
+    CHECK_EQ(twlcdcTouchReadSamples(out, TWLCDC_TOUCH_SAMPLES_PER_READ), TWLCDC_TOUCH_SAMPLES_PER_READ);
+    CHECK_EQ(out[0].rawx, 0x900);
+    CHECK_EQ(out[1].rawx, 0x800);
+    sim.glitch = 0;
+
+    // pen up
+    simTscSetPen(&sim, false, 0, 0, 0, 0);
+    CHECK_EQ(twlcdcTouchReadSamples(out, TWLCDC_TOUCH_SAMPLES_PER_READ), 0);
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,171 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - settings blob serialization and fast startup
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "settings.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define CONVERTED 64
+// offset of the filter byte in the blob
+#define FILTER_OFFSET (SETTINGS_HEADER_SIZE + 48)
+
+// a rotated panel, which only the affine transform describes
+static const twlcdcCalibrationPoint points[4] = {
+    { 0x240, 0x2A0, 32, 24 },
+    { 0xDF0, 0x330, 288, 24 },
+    { 0x1B0, 0xCD0, 32, 216 },
+    { 0xD60, 0xD60, 288, 216 },
+};
+
+static const twlcdcTouchCalibration other = {
+    0x100, 0x100, 0, 0, 0xF00, 0xF00, 319, 239
+};
+
+static void convert(twlcdcTouchPosition *out) {
+    twlcdcTouchPosition in[CONVERTED];
+    int i;
+
+    for (i = 0; i < CONVERTED; i++) {
+        memset(&in[i], 0, sizeof(in[i]));
+        in[i].rawx = 0x100 + i * 0x37;
+        in[i].rawy = 0xE00 - i * 0x2B;
+    }
+    twlcdcTouchConvertBatch(in, out, CONVERTED);
+}
+
+static void resave(u8 *blob) {
+    // keep the checksum valid after editing the payload
+    u32 crc = settingsCrc32(blob + SETTINGS_HEADER_SIZE, TWLCDC_SETTINGS_SIZE - SETTINGS_HEADER_SIZE);
+    blob[8] = crc;
+    blob[9] = crc >> 8;
+    blob[10] = crc >> 16;
+    blob[11] = crc >> 24;
+}
+
+int main(void) {
+    static const twlcdcPressureModel model = { 0x00C00000, 100 };
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchPosition expected[CONVERTED], actual[CONVERTED];
+    twlcdcTouchCalibration calibration;
+    twlcdcTscConfig config, restored;
+    twlcdcPressureModel restoredModel;
+    twlcdcPressureTracker tracker, restoredTracker;
+    u8 blob[TWLCDC_SETTINGS_SIZE + 4], again[TWLCDC_SETTINGS_SIZE], bad[TWLCDC_SETTINGS_SIZE];
+    FILE *file;
+    int i, bit;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+
+    // without saved settings, the calibration comes from the config service
+    CHECK(twlcdcInit());
+    CHECK_EQ(hostCfgCalls, 1);
+    twlcdcTouchCopyCalibration(&calibration);
+    CHECK_EQ(calibration.calX1, hostCalibration[0]);
+
+    // tune everything the blob holds
+    CHECK(twlcdcTouchSetCalibrationPoints(points, 4));
+    twlcdcTouchSetFilter(TWLCDC_FILTER_REJECT_SPREAD, 40);
+    twlcdcGetTscConfig(&config);
+    config.prechargeTime = 5;
+    config.scanTimer = 0x23;
+    twlcdcSetTscConfig(&config);
+    twlcdcTouchSetPressureModel(&model);
+    tracker.low = 123456;
+    tracker.high = 654321;
+    tracker.count = 999;
+    twlcdcTouchSetPressureTracking(&tracker);
+    convert(expected);
+
+    CHECK_EQ(twlcdcSettingsSave(blob, TWLCDC_SETTINGS_SIZE - 1), 0);
+    CHECK_EQ(twlcdcSettingsSave(blob, sizeof(blob)), TWLCDC_SETTINGS_SIZE);
+    CHECK(!memcmp(blob, SETTINGS_MAGIC, 4));
+    twlcdcExit();
+
+    // round trip: everything is restored, and saving again gives the same blob
+    twlcdcTouchSetCalibration(&other);
+    twlcdcTouchSetFilter(TWLCDC_FILTER_MEAN, 0);
+    twlcdcTouchSetPressureTracking(NULL);
+    CHECK(twlcdcSettingsLoad(blob, TWLCDC_SETTINGS_SIZE));
+    convert(actual);
+    CHECK(!memcmp(actual, expected, sizeof(actual)));
+    twlcdcGetTscConfig(&restored);
+    CHECK(!memcmp(&restored, &config, sizeof(config)));
+    twlcdcTouchGetPressureModel(&restoredModel);
+    CHECK_EQ(restoredModel.maxPressure, model.maxPressure);
+    CHECK_EQ(restoredModel.maxRadius, model.maxRadius);
+    CHECK(twlcdcTouchGetPressureTracking(&restoredTracker));
+    CHECK(!memcmp(&restoredTracker, &tracker, sizeof(tracker)));
+    CHECK_EQ(twlcdcSettingsSave(again, sizeof(again)), TWLCDC_SETTINGS_SIZE);
+    CHECK(!memcmp(again, blob, TWLCDC_SETTINGS_SIZE));
+
+    // startup with restored settings skips the config service and keeps
+    // the affine transform, which the two-point calibration cannot express
+    hostCfgCalls = 0;
+    CHECK(twlcdcInit());
+    CHECK_EQ(hostCfgCalls, 0);
+    convert(actual);
+    CHECK(!memcmp(actual, expected, sizeof(actual)));
+    // the restored TSC configuration is programmed into the controller
+    CHECK_EQ((sim.touchcnt[0x04] >> 4) & 7, 5);
+    CHECK_EQ(sim.touchcnt[0x0F], 0x23);
+    twlcdcExit();
+
+    // any corruption is rejected, and changes nothing
+    twlcdcTouchSetCalibration(&other);
+    convert(expected);
+    CHECK_EQ(twlcdcSettingsSave(again, sizeof(again)), TWLCDC_SETTINGS_SIZE);
+    for (i = 0; i < TWLCDC_SETTINGS_SIZE; i++) {
+        for (bit = 0; bit < 8; bit += 3) {
+            memcpy(bad, blob, TWLCDC_SETTINGS_SIZE);
+            bad[i] ^= 1 << bit;
+            CHECK(!twlcdcSettingsLoad(bad, TWLCDC_SETTINGS_SIZE));
+        }
+    }
+    convert(actual);
+    CHECK(!memcmp(actual, expected, sizeof(actual)));
+    CHECK_EQ(twlcdcSettingsSave(bad, sizeof(bad)), TWLCDC_SETTINGS_SIZE);
+    CHECK(!memcmp(bad, again, TWLCDC_SETTINGS_SIZE));
+
+    // other versions and sizes, truncation, and bad values with a valid checksum
+    memcpy(bad, blob, TWLCDC_SETTINGS_SIZE);
+    bad[4] = SETTINGS_VERSION + 1;
+    CHECK(!twlcdcSettingsLoad(bad, TWLCDC_SETTINGS_SIZE));
+    memcpy(bad, blob, TWLCDC_SETTINGS_SIZE);
+    bad[6] = TWLCDC_SETTINGS_SIZE - 4;
+    CHECK(!twlcdcSettingsLoad(bad, TWLCDC_SETTINGS_SIZE));
+    CHECK(!twlcdcSettingsLoad(blob, TWLCDC_SETTINGS_SIZE - 1));
+    CHECK(!twlcdcSettingsLoad(blob, 0));
+    memcpy(bad, blob, TWLCDC_SETTINGS_SIZE);
+    bad[FILTER_OFFSET] = TWLCDC_FILTER_REJECT_SPREAD + 1;
+    resave(bad);
+    CHECK(!twlcdcSettingsLoad(bad, TWLCDC_SETTINGS_SIZE));
+    bad[FILTER_OFFSET] = TWLCDC_FILTER_REJECT_SPREAD;
+    resave(bad);
+    CHECK(!memcmp(bad, blob, TWLCDC_SETTINGS_SIZE));
+    CHECK(twlcdcSettingsLoad(bad, TWLCDC_SETTINGS_SIZE));
+
+    // file round trip, and a truncated file
+    file = tmpfile();
+    CHECK(twlcdcSettingsSaveFile(file));
+    CHECK_EQ(ftell(file), TWLCDC_SETTINGS_SIZE);
+    rewind(file);
+    CHECK(twlcdcSettingsLoadFile(file));
+    fclose(file);
+    file = tmpfile();
+    fwrite(blob, TWLCDC_SETTINGS_SIZE - 1, 1, file);
+    rewind(file);
+    CHECK(!twlcdcSettingsLoadFile(file));
+    fclose(file);
+
+    return TEST_RESULT();
+}
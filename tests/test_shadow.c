@@ -0,0 +1,167 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - shadowed TSC register programming
+
+    Compares the controller state and register traffic against the
+    original per-field read-modify-write sequence. Run with an argument
+    to print the IPC counts.
+
+---------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+// The original sequence, one round-trip per access.
+typedef struct {
+    twlcdcBackend backend;
+    u8 backup[0x13];
+    u32 ipc;
+} legacy;
+
+static u8 legacyRead(legacy *l, u8 reg) {
+    u8 value;
+    l->ipc++;
+    l->backend.readRegisters(l->backend.userdata, SIM_BANK_TOUCHCNT, reg, &value, 1);
+    return value;
+}
+
+static void legacyWrite(legacy *l, u8 reg, u8 value) {
+    l->ipc++;
+    l->backend.writeRegisters(l->backend.userdata, SIM_BANK_TOUCHCNT, reg, &value, 1);
+}
+
+static void legacyMask(legacy *l, u8 reg, u8 mask, u8 value) {
+    legacyWrite(l, reg, (legacyRead(l, reg) & ~mask) | (value & mask));
+}
+
+static void legacyInit(legacy *l) {
+    static const u8 regs[] = { 0x02, 0x03, 0x04, 0x05, 0x0E, 0x0F, 0x12 };
+    int i, twice;
+
+    for (i = 0; i < 7; i++) {
+        l->backup[regs[i]] = legacyRead(l, regs[i]);
+    }
+    // every write was issued twice
+    for (twice = 0; twice < 2; twice++) legacyMask(l, 0x0E, 0x80, 0<<7);
+    for (twice = 0; twice < 2; twice++) legacyMask(l, 0x02, 0x18, 3<<3);
+    for (twice = 0; twice < 2; twice++) legacyWrite(l, 0x0F, 0xA0);
+    for (twice = 0; twice < 2; twice++) legacyMask(l, 0x0E, 0x38, 5<<3);
+    for (twice = 0; twice < 2; twice++) legacyMask(l, 0x0E, 0x40, 0<<6);
+    for (twice = 0; twice < 2; twice++) legacyWrite(l, 0x03, 0x8B);
+    for (twice = 0; twice < 2; twice++) legacyMask(l, 0x05, 0x07, 4<<0);
+    for (twice = 0; twice < 2; twice++) legacyMask(l, 0x04, 0x07, 6<<0);
+    for (twice = 0; twice < 2; twice++) legacyMask(l, 0x04, 0x70, 4<<4);
+    for (twice = 0; twice < 2; twice++) legacyMask(l, 0x12, 0x07, 0<<0);
+    for (twice = 0; twice < 2; twice++) legacyMask(l, 0x0E, 0x80, 1<<7);
+}
+
+static void legacyExit(legacy *l) {
+    legacyWrite(l, 0x05, l->backup[0x05]);
+    legacyWrite(l, 0x04, l->backup[0x04]);
+    legacyWrite(l, 0x12, l->backup[0x12]);
+    legacyWrite(l, 0x0F, l->backup[0x0F]);
+    legacyWrite(l, 0x03, l->backup[0x03]);
+    legacyWrite(l, 0x02, l->backup[0x02]);
+    legacyWrite(l, 0x0E, l->backup[0x0E]);
+}
+
+// Registers the library owns; 0x06..0x0D are status and data.
+static bool sameState(const simTsc *a, const simTsc *b) {
+    static const u8 regs[] = { 0x02, 0x03, 0x04, 0x05, 0x0E, 0x0F, 0x12 };
+    int i;
+
+    for (i = 0; i < 7; i++) {
+        if (a->touchcnt[regs[i]] != b->touchcnt[regs[i]]) {
+            fprintf(stderr, "register 0x%02X: 0x%02X != 0x%02X\n", regs[i],
+                a->touchcnt[regs[i]], b->touchcnt[regs[i]]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    simTsc sim, ref;
+    legacy old;
+    twlcdcBackend backend;
+    u32 seed = 1, ipc, ipcInit = 0, ipcResume = 0, ipcExit = 0;
+    u32 oldInit = 0, oldResume = 0, oldExit = 0;
+    int round, i;
+
+    hostReset();
+    for (round = 0; round < 64; round++) {
+        simTscInit(&sim);
+        // arbitrary power-on state, including bits the library must not touch
+        for (i = 0x02; i <= 0x12; i++) {
+            seed = seed * 1103515245 + 12345;
+            sim.touchcnt[i] = seed >> 16;
+        }
+        ref = sim;
+        memset(&old, 0, sizeof(old));
+        simTscBackend(&ref, &old.backend);
+        simTscBackend(&sim, &backend);
+        // both sequences make the same CTR read mode handover; compare
+        // the TSC programming alone
+        backend.readCtrRegisters = NULL;
+        backend.writeCtrRegisters = NULL;
+        twlcdcSetBackend(&backend);
+
+        // init
+        ipc = twlcdcGetIpcCount();
+        CHECK(twlcdcInit());
+        ipcInit = twlcdcGetIpcCount() - ipc;
+        legacyInit(&old);
+        oldInit = old.ipc;
+        CHECK(sameState(&sim, &ref));
+
+        // suspend and restore; the original code ran exit and init again
+        ipc = twlcdcGetIpcCount();
+        hostAptSignal(APTHOOK_ONSUSPEND);
+        legacyExit(&old);
+        CHECK(sameState(&sim, &ref));
+        // the system may reprogram the controller while we are away
+        sim.touchcnt[0x0F] = ref.touchcnt[0x0F] = 0x55;
+        hostAptSignal(APTHOOK_ONRESTORE);
+        ipcResume = twlcdcGetIpcCount() - ipc;
+        legacyInit(&old);
+        oldResume = old.ipc - oldInit;
+        CHECK(sameState(&sim, &ref));
+
+        // sleep and wake: the controller kept our settings
+        ipc = twlcdcGetIpcCount();
+        hostAptSignal(APTHOOK_ONSLEEP);
+        hostAptSignal(APTHOOK_ONWAKEUP);
+        CHECK(twlcdcGetIpcCount() - ipc <= 1);
+        CHECK(sameState(&sim, &ref));
+
+        // exit restores the values found on the last (re)initialization
+        ipc = twlcdcGetIpcCount();
+        twlcdcExit();
+        ipcExit = twlcdcGetIpcCount() - ipc;
+        ipc = old.ipc;
+        legacyExit(&old);
+        oldExit = old.ipc - ipc;
+        CHECK(sameState(&sim, &ref));
+        if (testFailures > 0) {
+            break;
+        }
+    }
+
+    if (argc > 1) {
+        printf("shadow,operation,ipc_before,ipc_after\n");
+        printf("shadow,init,%u,%u\n", oldInit, ipcInit);
+        printf("shadow,suspend_resume,%u,%u\n", oldResume, ipcResume);
+        printf("shadow,exit,%u,%u\n", oldExit, ipcExit);
+    }
+    CHECK_EQ(oldInit, 47);
+    CHECK_EQ(oldResume, 54);
+    CHECK_EQ(oldExit, 7);
+    CHECK(ipcInit <= 6);
+    CHECK(ipcResume <= 10);
+    CHECK(ipcExit <= 4);
+
+    return TEST_RESULT();
+}
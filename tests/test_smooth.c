@@ -0,0 +1,154 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - adaptive smoothing filter
+
+---------------------------------------------------------------------------------*/
+
+#include <math.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define MS HOST_TICKS_PER_MS
+#define PX(v) ((s32) ((v) * 65536.0))
+
+static const twlcdcSmootherConfig config = {
+    .minCutoff = 1 << 8,    // 1 Hz
+    .beta = 6554,           // 0.1 Hz per px/s
+};
+
+static u32 seed = 1;
+
+// uniform noise in [-amplitude, amplitude] pixels, 16.16
+static s32 noise(double amplitude) {
+    seed = seed * 1103515245 + 12345;
+    return PX(((seed >> 8) & 0xFFFF) / 32768.0 * amplitude - amplitude);
+}
+
+int main(void) {
+    twlcdcSmoother smoother;
+    double rawVar = 0, outVar = 0;
+    s32 x, y, last;
+    int i;
+
+    // stationary pen: jitter is strongly reduced
+    twlcdcSmootherInit(&smoother, &config);
+    for (i = 0; i < 1000; i++) {
+        s32 n = noise(1.5);
+        x = PX(160) + n;
+        y = PX(120);
+        twlcdcSmootherApply(&smoother, &x, &y, i * MS);
+        if (i >= 100) {
+            rawVar += pow(n / 65536.0, 2);
+            outVar += pow((x - PX(160)) / 65536.0, 2);
+        }
+    }
+    CHECK(sqrt(outVar) < sqrt(rawVar) / 4);
+
+    // steady stroke: the lag behind the pen stays small
+    twlcdcSmootherInit(&smoother, &config);
+    for (i = 0; i < 300; i++) {
+        x = PX(10 + i * 0.5);   // 500 px/s
+        y = PX(120);
+        twlcdcSmootherApply(&smoother, &x, &y, i * MS);
+    }
+    CHECK(PX(10 + 299 * 0.5) - x < PX(2));
+    CHECK(x <= PX(10 + 299 * 0.5));
+
+    // prediction tracks where the pen will be 16 ms later, 8 px ahead
+    {
+        twlcdcSmootherConfig predict = config;
+        predict.predictUs = 16000;
+        predict.alphaGain = 0x8000;
+        predict.betaGain = 0x1999;
+        twlcdcSmootherInit(&smoother, &predict);
+        for (i = 0; i < 300; i++) {
+            x = PX(10 + i * 0.5);
+            y = PX(120);
+            twlcdcSmootherApply(&smoother, &x, &y, i * MS);
+        }
+        CHECK(fabs((x - PX(10 + 299 * 0.5 + 8)) / 65536.0) < 1);
+    }
+
+    // flicks far above 32767 px/s: no wraparound, the output jumps along
+    twlcdcSmootherInit(&smoother, &config);
+    for (i = 0; i < 10; i++) {
+        x = PX(20);
+        y = PX(20);
+        twlcdcSmootherApply(&smoother, &x, &y, i * MS);
+    }
+    x = PX(300);            // 280 px in 1 ms
+    y = PX(220);
+    twlcdcSmootherApply(&smoother, &x, &y, 10 * MS);
+    CHECK(x > PX(120) && x <= PX(300));
+    CHECK(y > PX(90) && y <= PX(220));
+    last = x;
+    for (i = 11; i < 40; i++) {
+        x = PX(300);
+        y = PX(220);
+        twlcdcSmootherApply(&smoother, &x, &y, i * MS);
+        CHECK(x >= last && x <= PX(300));
+        last = x;
+    }
+    CHECK(PX(300) - x < PX(1));
+
+    // extreme inputs saturate
+    twlcdcSmootherInit(&smoother, &config);
+    for (i = 0; i < 10; i++) {
+        x = (i & 1) ? INT32_MAX : INT32_MIN;
+        y = 0;
+        twlcdcSmootherApply(&smoother, &x, &y, i * 16);
+    }
+
+    // through the library: a pen-up read starts a new stroke
+    {
+        simTsc sim;
+        twlcdcBackend backend;
+        twlcdcTouchPositionEx pos, fresh;
+
+        hostReset();
+        simTscInit(&sim);
+        sim.latencyTicks = MS;
+        simTscBackend(&sim, &backend);
+        twlcdcSetBackend(&backend);
+        CHECK(twlcdcInit());
+
+        simTscSetPen(&sim, true, 0xD00, 0xC00, 0x180, 0x900);
+        CHECK(twlcdcTouchReadEx(&fresh));
+
+        twlcdcTouchSetSmoothing(&config);
+        simTscSetPen(&sim, true, 0x300, 0x400, 0x180, 0x900);
+        for (i = 0; i < 20; i++) {
+            CHECK(twlcdcTouchReadEx(&pos));
+        }
+        simTscSetPen(&sim, false, 0, 0, 0, 0);
+        CHECK(!twlcdcTouchReadEx(&pos));
+        simTscSetPen(&sim, true, 0xD00, 0xC00, 0x180, 0x900);
+        CHECK(twlcdcTouchReadEx(&pos));
+        CHECK_EQ(pos.fx, fresh.fx);
+        CHECK_EQ(pos.fy, fresh.fy);
+
+        // likewise for polling, and for a pen-up status check
+        simTscSetPen(&sim, true, 0x300, 0x400, 0x180, 0x900);
+        CHECK(twlcdcTouchPollEx(&pos, TWLCDC_POLL_FAST));
+        simTscSetPen(&sim, false, 0, 0, 0, 0);
+        CHECK(!twlcdcTouchPollEx(&pos, TWLCDC_POLL_FAST));
+        simTscSetPen(&sim, true, 0xD00, 0xC00, 0x180, 0x900);
+        CHECK(twlcdcTouchPollEx(&pos, TWLCDC_POLL_FAST));
+        CHECK_EQ(pos.fx, fresh.fx);
+
+        simTscSetPen(&sim, true, 0x300, 0x400, 0x180, 0x900);
+        CHECK(twlcdcTouchReadEx(&pos));
+        simTscSetPen(&sim, false, 0, 0, 0, 0);
+        CHECK(!twlcdcTouchPenDown());
+        simTscSetPen(&sim, true, 0xD00, 0xC00, 0x180, 0x900);
+        CHECK(twlcdcTouchReadEx(&pos));
+        CHECK_EQ(pos.fx, fresh.fx);
+
+        twlcdcTouchSetSmoothing(NULL);
+        twlcdcExit();
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,100 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - statistics collection
+
+    Run with an argument to dump the collected statistics.
+
+---------------------------------------------------------------------------------*/
+
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define US HOST_TICKS_PER_US
+
+static void dump(const twlcdcStats *stats) {
+    static const char *names[] = { "init", "resume", "pen_down", "read", "poll" };
+    int op, i;
+
+    printf("ipc,touchcnt,%u\nipc,touchdata,%u\nipc,other,%u\ninvalid,%u\n",
+        stats->ipcTouchCnt, stats->ipcTouchData, stats->ipcOther, stats->invalidSamples);
+    for (op = 0; op < TWLCDC_STAT_COUNT; op++) {
+        const twlcdcLatencyStats *l = &stats->latency[op];
+        printf("latency,%s,%u,%llu,%llu,%llu", names[op], l->count,
+            (unsigned long long) l->minTicks,
+            (unsigned long long) (l->count ? l->totalTicks / l->count : 0),
+            (unsigned long long) l->maxTicks);
+        for (i = 0; i < TWLCDC_STATS_HISTOGRAM_SIZE; i++) {
+            printf(",%u", l->histogram[i]);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchPosition pos;
+    twlcdcStats stats;
+    int i, bucket;
+
+    hostReset();
+    simTscInit(&sim);
+    // every register access takes 50 us of simulated time
+    sim.latencyTicks = 50 * US;
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    twlcdcResetStats();
+    CHECK(twlcdcInit());
+
+    simTscSetPen(&sim, true, 0x800, 0x800, 0x180, 0x900);
+    for (i = 0; i < 100; i++) {
+        CHECK(twlcdcTouchPenDown());
+        CHECK(twlcdcTouchRead(&pos));
+    }
+    simTscSetPen(&sim, false, 0, 0, 0, 0);
+    for (i = 0; i < 20; i++) {
+        CHECK(!twlcdcTouchPoll(&pos, TWLCDC_POLL_FAST));
+    }
+    hostAptSignal(APTHOOK_ONSUSPEND);
+    hostAptSignal(APTHOOK_ONRESTORE);
+
+    CHECK(twlcdcGetStats(&stats));
+    if (argc > 1) {
+        dump(&stats);
+    }
+
+    // bank counters match the backend traffic exactly
+    CHECK_EQ(stats.ipcTouchData, sim.reads[SIM_BANK_TOUCHDATA]);
+    CHECK_EQ(stats.ipcTouchCnt, sim.reads[SIM_BANK_TOUCHCNT] + sim.writes[SIM_BANK_TOUCHCNT]);
+    // the CTR read mode handover on init, suspend and restore
+    CHECK_EQ(stats.ipcOther, sim.reads[SIM_CTR_PAGE] + sim.writes[SIM_CTR_PAGE]);
+    CHECK_EQ(stats.ipcOther, 6);
+    CHECK_EQ(stats.ipcTouchData + stats.ipcTouchCnt + stats.ipcOther, twlcdcGetIpcCount());
+    CHECK_EQ(stats.invalidSamples, 20);
+
+    // one access per pen check and per read, two per init
+    CHECK_EQ(stats.latency[TWLCDC_STAT_PEN_DOWN].count, 100);
+    CHECK_EQ(stats.latency[TWLCDC_STAT_PEN_DOWN].minTicks, 50 * US);
+    CHECK_EQ(stats.latency[TWLCDC_STAT_PEN_DOWN].maxTicks, 50 * US);
+    CHECK_EQ(stats.latency[TWLCDC_STAT_READ].count, 100);
+    CHECK_EQ(stats.latency[TWLCDC_STAT_READ].totalTicks, 100 * 50 * US);
+    CHECK_EQ(stats.latency[TWLCDC_STAT_POLL].count, 20);
+    CHECK_EQ(stats.latency[TWLCDC_STAT_INIT].count, 1);
+    CHECK(stats.latency[TWLCDC_STAT_INIT].minTicks >= 2 * 50 * US);
+    CHECK_EQ(stats.latency[TWLCDC_STAT_RESUME].count, 1);
+    CHECK(stats.latency[TWLCDC_STAT_RESUME].minTicks >= 50 * US);
+
+    // 50 us is 13400 ticks: 2^13 <= 13400 < 2^14
+    bucket = 13 - TWLCDC_STATS_HISTOGRAM_SHIFT;
+    CHECK_EQ(stats.latency[TWLCDC_STAT_READ].histogram[bucket], 100);
+
+    twlcdcResetStats();
+    CHECK(twlcdcGetStats(&stats));
+    CHECK_EQ(stats.ipcTouchCnt + stats.ipcTouchData + stats.invalidSamples, 0);
+    CHECK_EQ(stats.latency[TWLCDC_STAT_READ].count, 0);
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,127 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - stroke resampling on synthetic strokes
+
+---------------------------------------------------------------------------------*/
+
+#include <math.h>
+#include "twlcdc.h"
+#include "test.h"
+
+#define FIX(v) ((s32) lround((v) * 65536.0))
+#define SPACING FIX(2)
+
+static twlcdcStrokePoint arena[4096];
+
+static double pointDistance(const twlcdcStrokePoint *a, const twlcdcStrokePoint *b) {
+    return hypot(b->x - a->x, b->y - a->y) / 65536.0;
+}
+
+// A straight line with irregular spacing (dense, then sparse, as when the
+// pen speeds up): the output must never backtrack, must stay on the line,
+// and must be evenly spaced.
+static void testStraight(twlcdcStrokeSmoothing smoothing) {
+    static const double steps[] = { 0.5, 0.5, 0.5, 24, 1, 30, 0.25, 0.25, 16, 2, 40, 1 };
+    twlcdcStroke stroke;
+    twlcdcStrokePoint point;
+    double x = 10, backtrack = 0, offLine = 0, spacingError = 0;
+    size_t i;
+
+    twlcdcStrokeBegin(&stroke, arena, 4096, SPACING, smoothing);
+    for (i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        x += steps[i];
+        point.x = FIX(x);
+        point.y = FIX(50 + x / 2);
+        point.pressure = 100;
+        CHECK(twlcdcStrokeAdd(&stroke, &point));
+    }
+    CHECK(twlcdcStrokeEnd(&stroke));
+
+    CHECK_EQ(arena[0].x, FIX(10.5));
+    CHECK_EQ(arena[stroke.count - 1].x, point.x);
+    CHECK(stroke.count >= 60);
+    for (i = 1; i < stroke.count; i++) {
+        double dx = (arena[i].x - arena[i - 1].x) / 65536.0;
+        double y = 50 + arena[i].x / 65536.0 / 2;
+        if (-dx > backtrack) backtrack = -dx;
+        if (fabs(arena[i].y / 65536.0 - y) > offLine) offLine = fabs(arena[i].y / 65536.0 - y);
+        if (i < stroke.count - 1 && fabs(pointDistance(&arena[i - 1], &arena[i]) - 2) > spacingError) {
+            spacingError = fabs(pointDistance(&arena[i - 1], &arena[i]) - 2);
+        }
+        CHECK_EQ(arena[i].pressure, 100);
+    }
+    CHECK(backtrack == 0);
+    CHECK(offLine < 0.01);
+    CHECK(spacingError < 0.01);
+}
+
+// A circle sampled at irregular angles: points stay close to the circle,
+// and the spline follows it more closely than straight lines do.
+static double testCircle(twlcdcStrokeSmoothing smoothing) {
+    twlcdcStroke stroke;
+    twlcdcStrokePoint point;
+    double angle = 0, worst = 0;
+    u32 seed = 7;
+    size_t i;
+
+    twlcdcStrokeBegin(&stroke, arena, 4096, SPACING, smoothing);
+    while (angle < 2 * M_PI) {
+        point.x = FIX(160 + 80 * cos(angle));
+        point.y = FIX(120 + 80 * sin(angle));
+        point.pressure = 1000 + angle * 100;
+        CHECK(twlcdcStrokeAdd(&stroke, &point));
+        seed = seed * 1103515245 + 12345;
+        angle += 0.05 + ((seed >> 16) & 0xFF) / 255.0 * 0.3;
+    }
+    CHECK(twlcdcStrokeEnd(&stroke));
+
+    for (i = 0; i < stroke.count; i++) {
+        double r = hypot(arena[i].x / 65536.0 - 160, arena[i].y / 65536.0 - 120);
+        if (fabs(r - 80) > worst) worst = fabs(r - 80);
+        CHECK(arena[i].pressure >= 1000 && arena[i].pressure <= 1000 + 2 * M_PI * 100);
+        if (i > 0) {
+            CHECK(arena[i].pressure >= arena[i - 1].pressure);
+        }
+    }
+    return worst;
+}
+
+int main(void) {
+    twlcdcStroke stroke;
+    twlcdcStrokePoint point = { FIX(10), FIX(10), 0 };
+    double linear, spline;
+
+    testStraight(TWLCDC_STROKE_LINEAR);
+    testStraight(TWLCDC_STROKE_CATMULL_ROM);
+
+    linear = testCircle(TWLCDC_STROKE_LINEAR);
+    spline = testCircle(TWLCDC_STROKE_CATMULL_ROM);
+    CHECK(spline < 0.75);
+    CHECK(spline < linear * 0.6);
+
+    // repeated points (a resting pen) are harmless
+    twlcdcStrokeBegin(&stroke, arena, 4096, SPACING, TWLCDC_STROKE_CATMULL_ROM);
+    CHECK(twlcdcStrokeAdd(&stroke, &point));
+    CHECK(twlcdcStrokeAdd(&stroke, &point));
+    CHECK(twlcdcStrokeAdd(&stroke, &point));
+    point.x = FIX(20);
+    CHECK(twlcdcStrokeAdd(&stroke, &point));
+    CHECK(twlcdcStrokeAdd(&stroke, &point));
+    CHECK(twlcdcStrokeEnd(&stroke));
+    CHECK_EQ(stroke.count, 6);
+    CHECK_EQ(arena[5].x, FIX(20));
+    CHECK_EQ(arena[2].x, FIX(14));
+
+    // a full arena drops points and says so, without writing past it
+    twlcdcStrokeBegin(&stroke, arena, 3, SPACING, TWLCDC_STROKE_LINEAR);
+    point.x = FIX(10);
+    CHECK(twlcdcStrokeAdd(&stroke, &point));
+    point.x = FIX(31);
+    CHECK(!twlcdcStrokeAdd(&stroke, &point));
+    CHECK_EQ(stroke.count, 3);
+    twlcdcStrokeClear(&stroke);
+    CHECK(twlcdcStrokeEnd(&stroke));
+    CHECK_EQ(stroke.count, 1);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,110 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - sub-pixel coordinates from twlcdcTouchReadEx()
+
+---------------------------------------------------------------------------------*/
+
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+static const twlcdcTouchCalibration calibration = {
+    0x200, 0x300, 32, 24, 0xE00, 0xD00, 288, 216
+};
+
+// px/py must be the clamped integer parts of fx/fy, and the flags must
+// agree with the unclamped position
+static void checkConsistent(const twlcdcTouchPositionEx *pos) {
+    s32 px = pos->fx >> 16, py = pos->fy >> 16;
+    u32 flags = 0;
+
+    if (px < 0) {
+        px = 0;
+        flags |= TWLCDC_POSITION_OFF_LEFT;
+    } else if (px >= GSP_SCREEN_HEIGHT_BOTTOM) {
+        px = GSP_SCREEN_HEIGHT_BOTTOM - 1;
+        flags |= TWLCDC_POSITION_OFF_RIGHT;
+    }
+    if (py < 0) {
+        py = 0;
+        flags |= TWLCDC_POSITION_OFF_TOP;
+    } else if (py >= GSP_SCREEN_WIDTH) {
+        py = GSP_SCREEN_WIDTH - 1;
+        flags |= TWLCDC_POSITION_OFF_BOTTOM;
+    }
+    CHECK_EQ(pos->pos.px, px);
+    CHECK_EQ(pos->pos.py, py);
+    CHECK_EQ(pos->flags, flags);
+}
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchPositionEx ex, last = {0};
+    twlcdcTouchPosition pos;
+    u32 distinct = 0, flagged = 0;
+    s32 stepX, stepY;
+    int raw;
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+    twlcdcTouchSetCalibration(&calibration);
+
+    // X sweep over the full ADC range: fx never decreases, keeps the ADC
+    // resolution, and agrees with the integer path
+    for (raw = 0; raw <= 0xFFF; raw++) {
+        simTscSetPen(&sim, true, raw, 0x800, 0x180, 0x900);
+        CHECK(twlcdcTouchReadEx(&ex));
+        CHECK(twlcdcTouchRead(&pos));
+        CHECK_EQ(pos.px, ex.pos.px);
+        CHECK_EQ(pos.py, ex.pos.py);
+        checkConsistent(&ex);
+        if (raw > 0) {
+            CHECK(ex.fx >= last.fx);
+            CHECK_EQ(ex.fy, last.fy);
+            distinct += ex.fx != last.fx;
+        }
+        flagged |= ex.flags;
+        last = ex;
+    }
+    CHECK_EQ(distinct, 0xFFF);
+    CHECK_EQ(flagged, TWLCDC_POSITION_OFF_LEFT | TWLCDC_POSITION_OFF_RIGHT);
+
+    // the same for Y
+    distinct = 0;
+    flagged = 0;
+    for (raw = 0; raw <= 0xFFF; raw++) {
+        simTscSetPen(&sim, true, 0x800, raw, 0x180, 0x900);
+        CHECK(twlcdcTouchReadEx(&ex));
+        checkConsistent(&ex);
+        if (raw > 0) {
+            CHECK(ex.fy >= last.fy);
+            distinct += ex.fy != last.fy;
+        }
+        flagged |= ex.flags;
+        last = ex;
+    }
+    CHECK_EQ(distinct, 0xFFF);
+    CHECK_EQ(flagged, TWLCDC_POSITION_OFF_TOP | TWLCDC_POSITION_OFF_BOTTOM);
+
+    // calibration points land on their pixels, within one raw step: codes
+    // map to their centre, and the scale is rounded
+    stepX = ((288 - 32) << 16) / (calibration.calX2 - calibration.calX1);
+    stepY = ((216 - 24) << 16) / (calibration.calY2 - calibration.calY1);
+    simTscSetPen(&sim, true, calibration.calX1, calibration.calY1, 0x180, 0x900);
+    CHECK(twlcdcTouchReadEx(&ex));
+    CHECK(abs(ex.fx - (32 << 16)) <= stepX);
+    CHECK(abs(ex.fy - (24 << 16)) <= stepY);
+    CHECK_EQ(ex.flags, 0);
+    simTscSetPen(&sim, true, calibration.calX2, calibration.calY2, 0x180, 0x900);
+    CHECK(twlcdcTouchReadEx(&ex));
+    CHECK(abs(ex.fx - (288 << 16)) <= stepX);
+    CHECK(abs(ex.fy - (216 << 16)) <= stepY);
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,158 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - lock-free calibration and latest-sample snapshots
+
+---------------------------------------------------------------------------------*/
+
+#include <pthread.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "snapshot.h"
+#include "test.h"
+
+#define READERS 3
+#define ROUNDS 20000
+
+static const twlcdcTouchCalibration calibrations[2] = {
+    { 0x100, 0x100, 0, 0, 0xF00, 0xF00, 319, 239 },
+    { 0xF00, 0xF00, 0, 0, 0x100, 0x100, 319, 239 },
+};
+
+static twlcdcTouchPosition expected[2];
+static volatile int stop;
+static int torn;
+
+static void *writerThread(void *arg) {
+    int i;
+
+    (void) arg;
+    for (i = 0; i < ROUNDS; i++) {
+        twlcdcTouchSetCalibration(&calibrations[i & 1]);
+    }
+    __atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void *readerThread(void *arg) {
+    twlcdcTouchPosition in, out;
+    twlcdcTouchCalibration calibration;
+
+    (void) arg;
+    memset(&in, 0, sizeof(in));
+    in.rawx = 0x400;
+    in.rawy = 0xA00;
+    while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE)) {
+        twlcdcTouchConvertBatch(&in, &out, 1);
+        if ((out.px != expected[0].px || out.py != expected[0].py)
+            && (out.px != expected[1].px || out.py != expected[1].py)) {
+            __atomic_add_fetch(&torn, 1, __ATOMIC_RELAXED);
+        }
+        twlcdcTouchCopyCalibration(&calibration);
+        if (memcmp(&calibration, &calibrations[0], sizeof(calibration))
+            && memcmp(&calibration, &calibrations[1], sizeof(calibration))) {
+            __atomic_add_fetch(&torn, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcTouchPosition in, pos;
+    twlcdcTouchSample sample;
+    twlcdcTouchCalibration calibration;
+    pthread_t writer, readers[READERS];
+    snapshotState state;
+    u32 seq;
+    int i;
+
+    // a writer preempted half-way never holds up readers: they keep reading
+    // the last committed buffer
+    memset(&state, 0, sizeof(state));
+    i = snapshotWriteBegin(&state);
+    snapshotWriteEnd(&state, i);
+    CHECK_EQ(snapshotWriteBegin(&state), i ^ 1);
+    CHECK_EQ(snapshotReadBegin(&state, &seq), i);
+    CHECK(!snapshotReadRetry(&state, i, seq));
+    snapshotWriteEnd(&state, i ^ 1);
+    CHECK(!snapshotReadRetry(&state, i, seq));
+    // overtaken by a second write into the same buffer: retry
+    snapshotWriteBegin(&state);
+    CHECK(snapshotReadRetry(&state, i, seq));
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    // calibration is returned by copy
+    twlcdcTouchSetCalibration(&calibrations[0]);
+    twlcdcTouchCopyCalibration(&calibration);
+    CHECK(!memcmp(&calibration, &calibrations[0], sizeof(calibration)));
+    calibration.calX1px = 100;
+    twlcdcTouchCopyCalibration(&calibration);
+    CHECK_EQ(calibration.calX1px, 0);
+
+    // readers only ever see one of the two calibrations, never a mix
+    memset(&in, 0, sizeof(in));
+    in.rawx = 0x400;
+    in.rawy = 0xA00;
+    for (i = 0; i < 2; i++) {
+        twlcdcTouchSetCalibration(&calibrations[i]);
+        twlcdcTouchConvertBatch(&in, &expected[i], 1);
+    }
+    CHECK(expected[0].px != expected[1].px);
+    for (i = 0; i < READERS; i++) {
+        pthread_create(&readers[i], NULL, readerThread, NULL);
+    }
+    pthread_create(&writer, NULL, writerThread, NULL);
+    pthread_join(writer, NULL);
+    for (i = 0; i < READERS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+    CHECK_EQ(torn, 0);
+
+    // the latest sample follows the pen, including failed reads
+    CHECK(!twlcdcTouchGetLatest(&sample));
+    simTscSetPen(&sim, true, 0x800, 0x700, 0x180, 0x900);
+    hostAdvance(HOST_TICKS_PER_MS);
+    CHECK(twlcdcTouchRead(&pos));
+    CHECK(twlcdcTouchGetLatest(&sample));
+    CHECK_EQ(sample.pos.px, pos.px);
+    CHECK_EQ(sample.tick, svcGetSystemTick());
+
+    simTscSetPen(&sim, false, 0, 0, 0, 0);
+    hostAdvance(HOST_TICKS_PER_MS);
+    CHECK(!twlcdcTouchRead(&pos));
+    CHECK(!twlcdcTouchGetLatest(&sample));
+    CHECK_EQ(sample.tick, svcGetSystemTick());
+    CHECK_EQ(sample.pos.px, pos.px);
+
+    // repeated pen-up reads keep the release tick
+    hostAdvance(HOST_TICKS_PER_MS);
+    CHECK(!twlcdcTouchPoll(&pos, TWLCDC_POLL_FAST));
+    CHECK(!twlcdcTouchGetLatest(&sample));
+    CHECK_EQ(svcGetSystemTick() - sample.tick, HOST_TICKS_PER_MS);
+
+    // a pen-up check and an empty sample read are pen-up edges too
+    simTscSetPen(&sim, true, 0x800, 0x700, 0x180, 0x900);
+    CHECK(twlcdcTouchPoll(&pos, TWLCDC_POLL_CHECKED));
+    CHECK(twlcdcTouchGetLatest(&sample));
+    simTscSetPen(&sim, false, 0, 0, 0, 0);
+    CHECK(!twlcdcTouchPenDown());
+    CHECK(!twlcdcTouchGetLatest(&sample));
+
+    simTscSetPen(&sim, true, 0x800, 0x700, 0x180, 0x900);
+    CHECK(twlcdcTouchReadSamples(&pos, 1) == 1);
+    CHECK(twlcdcTouchGetLatest(&sample));
+    simTscSetPen(&sim, false, 0, 0, 0, 0);
+    CHECK_EQ(twlcdcTouchReadSamples(&pos, 1), 0);
+    CHECK(!twlcdcTouchGetLatest(&sample));
+
+    twlcdcExit();
+    return TEST_RESULT();
+}
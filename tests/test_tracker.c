@@ -0,0 +1,172 @@
+/*---------------------------------------------------------------------------------
+
+    libtwlcdc host tests - self-tuning pressure tracker
+
+---------------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "twlcdc.h"
+#include "host.h"
+#include "simtsc.h"
+#include "test.h"
+
+#define TRACE_HEADER 16
+#define TRACE_RECORD 48
+#define TRACE_READS 3000
+
+static u32 seed;
+
+static u32 random16(void) {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+static int compareU32(const void *a, const void *b) {
+    u32 x = *(const u32 *) a, y = *(const u32 *) b;
+    return x < y ? -1 : x > y;
+}
+
+// Feed a device's resistance distribution (uniform between min and max,
+// with rare outliers) and check the tracked range against its exact
+// percentiles.
+static void checkConvergence(u32 min, u32 max) {
+    static u32 values[20000];
+    twlcdcPressureTracker tracker;
+    u32 range = max - min;
+    int i;
+
+    twlcdcPressureTrackerInit(&tracker);
+    seed = 7;
+    for (i = 0; i < 20000; i++) {
+        values[i] = min + (u64) range * random16() / 0xFFFF;
+        // one sample in a hundred is a glitch far outside the range
+        twlcdcPressureTrackerUpdate(&tracker, i % 100 == 99 ? max * 8 : values[i]);
+    }
+    qsort(values, 20000, sizeof(u32), compareU32);
+    CHECK(abs((s32) (tracker.low - values[2000])) < range / 20);
+    CHECK(abs((s32) (tracker.high - values[18000])) < range / 10);
+    CHECK_EQ(tracker.count, 20000);
+}
+
+// A replayable capture of presses of varying firmness, on a device whose
+// touch resistance is scaled by the given factor.
+static u8 *makeTrace(u32 scale, size_t *size) {
+    u8 *data;
+    int i;
+
+    *size = TRACE_HEADER + TRACE_READS * TRACE_RECORD;
+    data = calloc(1, *size);
+    memcpy(data, "TWLT", 4);
+    data[4] = 1;
+    data[6] = TRACE_RECORD;
+    seed = 11;
+    for (i = 0; i < TRACE_READS; i++) {
+        u8 *record = data + TRACE_HEADER + i * TRACE_RECORD;
+        u32 firmness = random16() & 0xFF;
+        simPen pen = { (i % 50) < 45, 0x800, 0x800, 0x200, 0x200 + (0x300 - firmness * 2) * scale / 4 };
+        u64 tick = (u64) i * HOST_TICKS_PER_MS * 4;
+
+        memcpy(record, &tick, 8);
+        simTscEncode(&pen, record + 8);
+    }
+    return data;
+}
+
+// Replay a capture with pressure tracking, recording the normalized level
+// of every read.
+static void replayLevels(const u8 *data, size_t size, const twlcdcPressureTracker *initial, u32 *levels, twlcdcPressureTracker *final) {
+    twlcdcReplay replay;
+    twlcdcBackend backend;
+    twlcdcTouchPositionEx pos;
+    int i;
+
+    memset(&backend, 0, sizeof(backend));
+    CHECK(twlcdcReplayInit(&replay, data, size));
+    twlcdcReplayBackend(&replay, &backend);
+    twlcdcSetBackend(&backend);
+    twlcdcTouchSetPressureTracking(initial);
+    for (i = 0; i < TRACE_READS; i++) {
+        levels[i] = twlcdcTouchReadEx(&pos) ? pos.level : 0xFFFFFFFF;
+    }
+    CHECK(twlcdcTouchGetPressureTracking(final));
+    twlcdcTouchSetPressureTracking(NULL);
+}
+
+int main(void) {
+    static u32 first[TRACE_READS], second[TRACE_READS], scaled[TRACE_READS];
+    simTsc sim;
+    twlcdcBackend backend;
+    twlcdcPressureTracker tracker, fresh, final1, final2;
+    u8 *data, *data3;
+    size_t size;
+    u32 level, previous;
+    int i, worst = 0;
+
+    // the tracked range settles on the 10th and 90th percentiles, whatever
+    // the device's scale
+    checkConvergence(1000, 3000);
+    checkConvergence(200000, 900000);
+
+    // normalization: firmer presses give higher levels, within 0..1
+    tracker.low = 1000;
+    tracker.high = 3000;
+    tracker.count = 1000;
+    CHECK_EQ(twlcdcPressureTrackerNormalize(&tracker, 0), 0);
+    CHECK_EQ(twlcdcPressureTrackerNormalize(&tracker, 3000), 0);
+    CHECK_EQ(twlcdcPressureTrackerNormalize(&tracker, 1000), 0x10000);
+    CHECK(abs((int) twlcdcPressureTrackerNormalize(&tracker, 2000) - 0x8000) <= 1);
+    previous = 0;
+    for (i = 3100; i >= 900; i--) {
+        level = twlcdcPressureTrackerNormalize(&tracker, i);
+        CHECK(level >= previous && level <= 0x10000);
+        previous = level;
+    }
+
+    hostReset();
+    simTscInit(&sim);
+    simTscBackend(&sim, &backend);
+    twlcdcSetBackend(&backend);
+    CHECK(twlcdcInit());
+
+    // replays of the same capture learn exactly the same model
+    data = makeTrace(1, &size);
+    twlcdcPressureTrackerInit(&fresh);
+    replayLevels(data, size, &fresh, first, &final1);
+    replayLevels(data, size, &fresh, second, &final2);
+    CHECK(!memcmp(first, second, sizeof(first)));
+    CHECK(!memcmp(&final1, &final2, sizeof(final1)));
+    CHECK_EQ(final1.count, TRACE_READS / 50 * 45);
+
+    // an exported model picks up where it left off: a second pass starting
+    // from it matches the first pass's settled levels
+    replayLevels(data, size, &final1, second, &final2);
+    for (i = TRACE_READS / 2; i < TRACE_READS; i++) {
+        if (first[i] != 0xFFFFFFFF) {
+            int diff = abs((int) first[i] - (int) second[i]);
+            if (diff > worst) worst = diff;
+        }
+    }
+    CHECK(worst < 0x1000);
+
+    // a device with three times the touch resistance reports the same
+    // levels once settled
+    data3 = makeTrace(3, &size);
+    replayLevels(data3, size, &fresh, scaled, &final2);
+    CHECK(final2.high > final1.high * 2);
+    worst = 0;
+    for (i = TRACE_READS / 2; i < TRACE_READS; i++) {
+        CHECK_EQ(first[i] == 0xFFFFFFFF, scaled[i] == 0xFFFFFFFF);
+        if (first[i] != 0xFFFFFFFF) {
+            int diff = abs((int) first[i] - (int) scaled[i]);
+            if (diff > worst) worst = diff;
+        }
+    }
+    CHECK(worst < 0x1800);
+
+    free(data);
+    free(data3);
+    twlcdcSetBackend(&backend);
+    twlcdcExit();
+    return TEST_RESULT();
+}